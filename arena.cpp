@@ -0,0 +1,60 @@
+#include "arena.h"
+
+alignas(ARENA_DEFAULT_ALIGN) uint8_t arenaStorage[GIZMOLED_ARENA_SIZE];
+size_t arenaUsed = 0;
+size_t arenaPeak = 0;
+bool arenaExhausted = false;
+
+namespace GizmoLED
+{
+	void *ArenaAlloc(size_t size, size_t align)
+	{
+		const size_t begin = (arenaUsed + align - 1) & ~(align - 1);
+		if (begin + size > GIZMOLED_ARENA_SIZE)
+		{
+			Serial.println("GizmoLED arena exhausted, increase GIZMOLED_ARENA_SIZE");
+			arenaExhausted = true;
+			return nullptr;
+		}
+
+		arenaUsed = begin + size;
+		if (arenaUsed > arenaPeak)
+		{
+			arenaPeak = arenaUsed;
+		}
+		return arenaStorage + begin;
+	}
+
+	size_t ArenaMark()
+	{
+		return arenaUsed;
+	}
+
+	void ArenaRelease(size_t mark)
+	{
+		if (mark < arenaUsed)
+		{
+			arenaUsed = mark;
+		}
+	}
+
+	bool IsArenaExhausted()
+	{
+		return arenaExhausted;
+	}
+
+	size_t GetArenaUsed()
+	{
+		return arenaUsed;
+	}
+
+	size_t GetArenaPeak()
+	{
+		return arenaPeak;
+	}
+
+	size_t GetArenaSize()
+	{
+		return GIZMOLED_ARENA_SIZE;
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Arduino.h>
+#include <new>
+
+// Static memory for all GizmoLED allocations, override with a build flag if it runs out
+#ifndef GIZMOLED_ARENA_SIZE
+#ifdef ARDUINO_ARCH_NRF52840
+#define GIZMOLED_ARENA_SIZE 12288 // Includes the scratch block for flash writes
+#else
+#define GIZMOLED_ARENA_SIZE 8192
+#endif
+#endif
+
+#define ARENA_DEFAULT_ALIGN 8
+
+namespace GizmoLED
+{
+	// Bump allocator, memory is never freed except for scratch blocks released through a mark.
+	// Returns nullptr when the arena is full.
+	extern void *ArenaAlloc(size_t size, size_t align = ARENA_DEFAULT_ALIGN);
+
+	template<typename T>
+	inline T *ArenaAllocArray(size_t count)
+	{
+		return static_cast<T*>(ArenaAlloc(sizeof(T) * count, alignof(T)));
+	}
+
+	// Scratch usage: mark, allocate temporary blocks, then release back to the mark
+	extern size_t ArenaMark();
+	extern void ArenaRelease(size_t mark);
+
+	// True once any allocation has failed, including optional ones like layouts
+	extern bool IsArenaExhausted();
+
+	extern size_t GetArenaUsed();
+	extern size_t GetArenaPeak();
+	extern size_t GetArenaSize();
+}
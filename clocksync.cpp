@@ -0,0 +1,249 @@
+#include <ArduinoBLE.h>
+
+#include "clocksync.h"
+#include "linkpolicy.h"
+
+using namespace GizmoLED;
+
+// Flags, a 128-bit service UUID and the manufacturer data field header
+static_assert(3 + 18 + 2 + SYNC_BEACON_SIZE <= 31, "Sync beacon doesn't fit in the advertising packet");
+
+SyncRole syncRole = SYNCROLE_NONE;
+ClockSync clockSync = {};
+uint8_t syncSequence = 0;
+unsigned long lastBeaconTime = 0;
+uint8_t syncBeacon[SYNC_BEACON_SIZE]; // ArduinoBLE keeps the pointer until it advertises
+
+inline int32_t PhaseDifference(uint32_t a, uint32_t b)
+{
+	return int32_t(a - b);
+}
+
+inline int32_t PhaseToMicros(int32_t phase)
+{
+	return int32_t((int64_t(phase) * 1000000) >> 16);
+}
+
+void StartBeacon(uint32_t phase, uint8_t effectName)
+{
+	const int length = ClockSyncWriteBeacon(syncBeacon, syncSequence++, phase, effectName);
+
+	BLE.stopAdvertise();
+	BLE.setManufacturerData(syncBeacon, length);
+	BLE.setAdvertisingInterval(SYNC_ADVERTISING_INTERVAL);
+	BLE.advertise();
+}
+
+// Back to plain advertising at the link policy interval
+void StopBeacon()
+{
+	BLE.stopAdvertise();
+	BLE.setManufacturerData(syncBeacon, 0);
+	BLE.setAdvertisingInterval(GetLinkPolicy().advertisingInterval);
+	if (!BLE.connected())
+	{
+		BLE.advertise();
+	}
+}
+
+void ReceiveBeacons(uint32_t localPhase)
+{
+	BLEDevice device = BLE.available();
+	while (device)
+	{
+		if (device.hasManufacturerData() && device.manufacturerDataLength() == SYNC_BEACON_SIZE)
+		{
+			uint8_t beacon[SYNC_BEACON_SIZE];
+			device.manufacturerData(beacon, SYNC_BEACON_SIZE);
+
+			uint8_t sequence;
+			uint32_t phase;
+			uint8_t effectName;
+			if (ClockSyncReadBeacon(beacon, SYNC_BEACON_SIZE, &sequence, &phase, &effectName))
+			{
+				ClockSyncSample(clockSync, phase, sequence, localPhase);
+			}
+		}
+		device = BLE.available();
+	}
+}
+
+namespace GizmoLED
+{
+	int ClockSyncWriteBeacon(uint8_t *beacon, uint8_t sequence, uint32_t phase, uint8_t effectName)
+	{
+		beacon[0] = SYNC_COMPANY_ID & 0xFF;
+		beacon[1] = SYNC_COMPANY_ID >> 8;
+		beacon[2] = (SYNC_MAGIC << 4) | (sequence & SYNC_SEQUENCE_MASK);
+		beacon[3] = phase;
+		beacon[4] = phase >> 8;
+		beacon[5] = phase >> 16;
+		beacon[6] = phase >> 24;
+		beacon[7] = effectName;
+		return SYNC_BEACON_SIZE;
+	}
+
+	bool ClockSyncReadBeacon(const uint8_t *beacon, int length, uint8_t *sequence, uint32_t *phase, uint8_t *effectName)
+	{
+		if (length < SYNC_BEACON_SIZE ||
+			beacon[0] != (SYNC_COMPANY_ID & 0xFF) ||
+			beacon[1] != (SYNC_COMPANY_ID >> 8) ||
+			(beacon[2] >> 4) != SYNC_MAGIC)
+		{
+			return false;
+		}
+
+		*sequence = beacon[2] & SYNC_SEQUENCE_MASK;
+		*phase = uint32_t(beacon[3]) | (uint32_t(beacon[4]) << 8) |
+			(uint32_t(beacon[5]) << 16) | (uint32_t(beacon[6]) << 24);
+		*effectName = beacon[7];
+		return true;
+	}
+
+	void ClockSyncReset(ClockSync &sync)
+	{
+		sync = ClockSync();
+	}
+
+	void ClockSyncSample(ClockSync &sync, uint32_t masterPhase, uint8_t sequence, uint32_t localPhase)
+	{
+		// Beacons are rebroadcast until the master updates them, only the first
+		// reception of each sequence has a small delay
+		sequence &= SYNC_SEQUENCE_MASK;
+		if (sync.hasSequence && sequence == sync.lastSequence)
+			return;
+
+		if (sync.hasSequence)
+		{
+			sync.lost += (sequence - sync.lastSequence - 1) & SYNC_SEQUENCE_MASK;
+		}
+		sync.hasSequence = true;
+		sync.lastSequence = sequence;
+		++sync.samples;
+
+		// Delays only make the master look behind, keep the largest offset of the window
+		const int32_t measured = PhaseDifference(masterPhase, localPhase);
+		if (sync.windowSamples == 0 || PhaseDifference(measured, sync.windowOffset) > 0)
+		{
+			sync.windowOffset = measured;
+			sync.windowLocal = localPhase;
+		}
+
+		if (++sync.windowSamples < SYNC_WINDOW)
+			return;
+
+		sync.windowSamples = 0;
+
+		if (!sync.locked)
+		{
+			sync.offset = sync.windowOffset;
+			sync.drift = 0;
+			sync.lastLocal = sync.windowLocal;
+			sync.anchorOffset = sync.windowOffset;
+			sync.anchorLocal = sync.windowLocal;
+			sync.anchorWindows = 0;
+			sync.locked = true;
+			sync.phaseError = 0;
+			return;
+		}
+
+		const int32_t modelAtWindow = PhaseDifference(ClockSyncPhase(sync, sync.windowLocal), sync.windowLocal);
+		sync.phaseError = PhaseDifference(sync.windowOffset, modelAtWindow);
+
+		// Move half way to the new estimate, which halves the delay jitter passed on to the phase
+		sync.offset = modelAtWindow + sync.phaseError / 2;
+		sync.lastLocal = sync.windowLocal;
+
+		if (++sync.anchorWindows < SYNC_DRIFT_WINDOWS)
+			return;
+
+		const int32_t baseline = PhaseDifference(sync.windowLocal, sync.anchorLocal);
+		if (baseline > 0)
+		{
+			int64_t slope = (int64_t(PhaseDifference(sync.windowOffset, sync.anchorOffset)) * (int64_t(1) << 24)) / baseline;
+			slope = slope > SYNC_MAX_DRIFT ? SYNC_MAX_DRIFT : (slope < -SYNC_MAX_DRIFT ? -SYNC_MAX_DRIFT : slope);
+			sync.drift = sync.hasDrift ? int32_t((sync.drift * 3 + slope) / 4) : int32_t(slope);
+			sync.hasDrift = true;
+		}
+
+		sync.anchorOffset = sync.windowOffset;
+		sync.anchorLocal = sync.windowLocal;
+		sync.anchorWindows = 0;
+	}
+
+	uint32_t ClockSyncPhase(const ClockSync &sync, uint32_t localPhase)
+	{
+		if (!sync.locked)
+			return localPhase;
+
+		const int32_t elapsed = PhaseDifference(localPhase, sync.lastLocal);
+		const int32_t correction = int32_t((int64_t(elapsed) * sync.drift) >> 24);
+		return localPhase + sync.offset + correction;
+	}
+
+	void SetSyncRole(SyncRole role)
+	{
+		if (syncRole == SYNCROLE_FOLLOWER)
+		{
+			BLE.stopScan();
+		}
+
+		const bool stopBeacon = syncRole == SYNCROLE_MASTER && role != SYNCROLE_MASTER;
+		syncRole = role;
+		if (stopBeacon)
+		{
+			StopBeacon();
+		}
+		ClockSyncReset(clockSync);
+
+		if (role == SYNCROLE_FOLLOWER)
+		{
+			BLE.scan(true);
+		}
+	}
+
+	SyncRole GetSyncRole()
+	{
+		return syncRole;
+	}
+
+	uint32_t UpdateClockSync(uint32_t localPhase, uint8_t effectName)
+	{
+		switch (syncRole)
+		{
+		case SYNCROLE_MASTER:
+		{
+			const unsigned long now = millis();
+			if (now - lastBeaconTime >= SYNC_BEACON_INTERVAL)
+			{
+				lastBeaconTime = now;
+				StartBeacon(localPhase, effectName);
+			}
+			return localPhase;
+		}
+
+		case SYNCROLE_FOLLOWER:
+		{
+			// Without beacons the clock keeps running on the last offset and drift
+			ReceiveBeacons(localPhase);
+			return ClockSyncPhase(clockSync, localPhase);
+		}
+
+		default:
+			return localPhase;
+		}
+	}
+
+	void PrintClockSyncStats()
+	{
+		if (syncRole == SYNCROLE_NONE)
+			return;
+
+		Serial.println("Sync: " + String(syncRole == SYNCROLE_MASTER ? "master" : "follower") +
+			", locked: " + String(clockSync.locked ? 1 : 0) +
+			", samples: " + String(clockSync.samples) +
+			", lost: " + String(clockSync.lost) +
+			", phase error: " + String(PhaseToMicros(clockSync.phaseError)) + "us" +
+			", drift: " + String(clockSync.drift / 16.777216f) + "ppm");
+	}
+}
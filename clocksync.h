@@ -0,0 +1,68 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <gizmoled.h>
+
+#define SYNC_COMPANY_ID 0xFFFF // Reserved for testing, no registered company
+#define SYNC_MAGIC 0xA // High nibble of the sequence byte
+#define SYNC_SEQUENCE_MASK 0x0F
+#define SYNC_BEACON_SIZE 8 // Fits next to the flags and a 128-bit service UUID in 31 bytes
+#define SYNC_BEACON_INTERVAL 100 // ms between beacon updates on the master
+#define SYNC_ADVERTISING_INTERVAL 32 // 20ms, short so beacons arrive fresh
+#define SYNC_WINDOW 8 // Beacons per offset estimate
+#define SYNC_DRIFT_WINDOWS 32 // Windows between drift measurements, a long baseline averages out delay jitter
+#define SYNC_MAX_DRIFT 8389 // 500ppm in 2^-24 units
+
+namespace GizmoLED
+{
+	enum SyncRole
+	{
+		SYNCROLE_NONE = 0,
+		SYNCROLE_MASTER,
+		SYNCROLE_FOLLOWER,
+	};
+
+	// Follower clock disciplined to the master phase. Times are Q16 seconds like FixedFrameTime::phase.
+	struct ClockSync
+	{
+		bool locked;
+		int32_t offset; // Master minus local phase at lastLocal
+		int32_t drift; // Master rate error in 2^-24 units
+		uint32_t lastLocal;
+
+		int32_t anchorOffset; // Start of the drift baseline
+		uint32_t anchorLocal;
+		uint8_t anchorWindows;
+		bool hasDrift;
+
+		bool hasSequence;
+		uint8_t lastSequence; // 4 bits, losses of more than 15 beacons in a row are undercounted
+		uint8_t windowSamples;
+		int32_t windowOffset; // Least delayed offset in the current window
+		uint32_t windowLocal;
+
+		// Statistics
+		uint32_t samples;
+		uint32_t lost;
+		int32_t phaseError; // Last correction
+	};
+
+	// Beacon layout: company id, magic and sequence in one byte, master phase, effect name
+	extern int ClockSyncWriteBeacon(uint8_t *beacon, uint8_t sequence, uint32_t phase, uint8_t effectName);
+	extern bool ClockSyncReadBeacon(const uint8_t *beacon, int length, uint8_t *sequence, uint32_t *phase, uint8_t *effectName);
+
+	extern void ClockSyncReset(ClockSync &sync);
+
+	// Feeds a beacon received at localPhase
+	extern void ClockSyncSample(ClockSync &sync, uint32_t masterPhase, uint8_t sequence, uint32_t localPhase);
+
+	// Maps the local phase to the master phase
+	extern uint32_t ClockSyncPhase(const ClockSync &sync, uint32_t localPhase);
+
+	// BLE side, called by the loop
+	extern void SetSyncRole(SyncRole role);
+	extern SyncRole GetSyncRole();
+	extern uint32_t UpdateClockSync(uint32_t localPhase, uint8_t effectName);
+	extern void PrintClockSyncStats();
+}
@@ -0,0 +1,152 @@
+#include <ArduinoBLE.h>
+
+#include "colorpalette.h"
+
+using namespace GizmoLED;
+
+Palette *palettes[MAX_PALETTES] = { nullptr };
+int numPalettes = 0;
+
+namespace GizmoLED
+{
+	bool RegisterPalette(Palette &palette, EffectName effectName)
+	{
+		palette.effectName = effectName;
+		palette.dirty = true;
+
+		// An unregistered palette would never see its settings change
+		if (numPalettes >= MAX_PALETTES)
+		{
+			Serial.println("GizmoLED palette limit reached, increase MAX_PALETTES");
+			return false;
+		}
+
+		palettes[numPalettes++] = &palette;
+		return true;
+	}
+
+	void InvalidatePalettes(EffectName effectName)
+	{
+		for (int i = 0; i < numPalettes; ++i)
+		{
+			if (palettes[i]->effectName == effectName)
+			{
+				palettes[i]->dirty = true;
+			}
+		}
+	}
+
+	bool IsPaletteVar(VarName name)
+	{
+		switch (name)
+		{
+		case VARNAME_COLOR:
+		case VARNAME_COLOR1:
+		case VARNAME_COLOR2:
+		case VARNAME_COLOR3:
+		case VARNAME_NUMBEROFCOLORS:
+		case VARNAME_RAINBOWENABLED:
+		case VARNAME_RAINBOWLENGTH:
+		case VARNAME_RAINBOWOFFSET:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// Slider value relative to its max
+	float GetSliderFraction(const uint8_t *slider, float defaultValue)
+	{
+		if (slider == nullptr || slider[2] == 0)
+			return defaultValue;
+
+		return float(slider[0]) / slider[2];
+	}
+
+	void BakeRainbow(Palette &palette, const Effect &effect)
+	{
+		const float length = GetSliderFraction(FindEffectVar(effect, VARNAME_RAINBOWLENGTH), 1.0f);
+		const float offset = GetSliderFraction(FindEffectVar(effect, VARNAME_RAINBOWOFFSET), 0.0f);
+
+		for (int i = 0; i < PALETTE_SIZE; ++i)
+		{
+			float hue = (offset + length * i / PALETTE_SIZE) * 360.0f;
+			hue -= floor(hue / 360.0f) * 360.0f;
+			HSV2RGB(hue, 100.0f, 100.0f, palette.rgb[i]);
+		}
+	}
+
+	void BakeGradient(Palette &palette, const Effect &effect)
+	{
+		const uint8_t *colors[3];
+		int numColors = 0;
+
+		const VarName colorVars[] = { VARNAME_COLOR1, VARNAME_COLOR2, VARNAME_COLOR3 };
+		for (VarName name : colorVars)
+		{
+			const uint8_t *color = FindEffectVar(effect, name);
+			if (color != nullptr)
+			{
+				colors[numColors++] = color;
+			}
+		}
+
+		if (numColors == 0)
+		{
+			const uint8_t *color = FindEffectVar(effect, VARNAME_COLOR);
+			if (color == nullptr)
+			{
+				memset(palette.rgb, 0, sizeof palette.rgb);
+				return;
+			}
+			colors[numColors++] = color;
+		}
+
+		const uint8_t *numberOfColors = FindEffectVar(effect, VARNAME_NUMBEROFCOLORS);
+		if (numberOfColors != nullptr)
+		{
+			numColors = MAX(1, MIN(numColors, *numberOfColors));
+		}
+
+		// Cyclic blend so the palette wraps seamlessly
+		for (int i = 0; i < PALETTE_SIZE; ++i)
+		{
+			const int position = i * numColors;
+			const uint8_t *a = colors[position / PALETTE_SIZE];
+			const uint8_t *b = colors[(position / PALETTE_SIZE + 1) % numColors];
+			const uint16_t fb = position % PALETTE_SIZE;
+			const uint16_t fa = PALETTE_SIZE - fb;
+			for (int c = 0; c < 3; ++c)
+			{
+				palette.rgb[i][c] = (a[c] * fa + b[c] * fb) / PALETTE_SIZE;
+			}
+		}
+	}
+
+	void BakePalette(Palette &palette, const Effect &effect)
+	{
+		const uint8_t *rainbowEnabled = FindEffectVar(effect, VARNAME_RAINBOWENABLED);
+		if (rainbowEnabled != nullptr && *rainbowEnabled != 0)
+		{
+			BakeRainbow(palette, effect);
+		}
+		else
+		{
+			BakeGradient(palette, effect);
+		}
+
+		palette.dirty = false;
+	}
+
+	void UpdatePalette(Palette &palette)
+	{
+		if (!palette.dirty)
+			return;
+
+		const Effect *effect = FindEffect(palette.effectName);
+		if (effect != nullptr)
+		{
+			BakePalette(palette, *effect);
+		}
+	}
+}
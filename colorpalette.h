@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <gizmoled.h>
+
+#define PALETTE_SIZE 256
+#ifndef MAX_PALETTES
+#define MAX_PALETTES 8
+#endif
+
+namespace GizmoLED
+{
+	// 256 entry RGB palette baked from the color vars of an effect.
+	// It is only rebuilt after the effect's color settings have changed.
+	struct Palette
+	{
+		EffectName effectName;
+		bool dirty;
+		uint8_t rgb[PALETTE_SIZE][3];
+	};
+
+	// Returns false when MAX_PALETTES palettes are registered already
+	extern bool RegisterPalette(Palette &palette, EffectName effectName);
+	extern void InvalidatePalettes(EffectName effectName);
+	extern bool IsPaletteVar(VarName name);
+
+	extern void BakePalette(Palette &palette, const Effect &effect);
+
+	// Rebakes the palette if its settings changed, call once per frame before sampling
+	extern void UpdatePalette(Palette &palette);
+
+	inline const uint8_t *PaletteSample(const Palette &palette, uint8_t index)
+	{
+		return palette.rgb[index];
+	}
+
+	// Samples with linear blending, position is 8.8 fixed point
+	inline void PaletteSampleOffset(const Palette &palette, uint16_t position, uint8_t *rgb)
+	{
+		const uint8_t *a = palette.rgb[position >> 8];
+		const uint8_t *b = palette.rgb[uint8_t((position >> 8) + 1)];
+		const uint16_t fb = position & 0xFF;
+		const uint16_t fa = 256 - fb;
+		rgb[0] = (a[0] * fa + b[0] * fb) >> 8;
+		rgb[1] = (a[1] * fa + b[1] * fb) >> 8;
+		rgb[2] = (a[2] * fa + b[2] * fb) >> 8;
+	}
+}
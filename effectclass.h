@@ -0,0 +1,269 @@
+#pragma once
+
+#include <Arduino.h>
+#include <new>
+
+#include <gizmoled.h>
+
+// Effects written as classes instead of a bare FnEffectAnimation:
+//
+//	class Fire : public GizmoLED::EffectClass<Fire>
+//	{
+//	public:
+//		void begin() { speed = slider(GizmoLED::VARNAME_SPEED); }
+//		void render(float frameTime) { ... } // Or render(const GizmoLED::FixedFrameTime &time)
+//	private:
+//		GizmoLED::SliderVar speed;
+//		uint8_t heat[NUM_LEDS];
+//	};
+//
+//	GIZMOLED_EFFECT_ARENA(Fire, Wheel);
+//
+//	BEGIN_EFFECTS()
+//	DECLARE_EFFECT_CLASS(fire, Fire, GizmoLED::EFFECTTYPE_DEFAULT)
+//	...
+//
+// Only the active effect is constructed, inside one arena sized to the largest class.
+// Effects are called by their index in the arena list, so render() is inlined into the dispatch.
+
+namespace GizmoLED
+{
+	struct ColorVar
+	{
+		const uint8_t *values;
+
+		uint8_t r() const { return values[0]; }
+		uint8_t g() const { return values[1]; }
+		uint8_t b() const { return values[2]; }
+		const uint8_t *rgb() const { return values; }
+	};
+
+	struct SliderVar
+	{
+		const uint8_t *values;
+
+		uint8_t value() const { return values[0]; }
+		uint8_t min() const { return values[1]; }
+		uint8_t max() const { return values[2]; }
+		float fraction() const { return values[2] > 0 ? float(values[0]) / values[2] : 0.0f; }
+	};
+
+	struct CheckboxVar
+	{
+		const uint8_t *values;
+
+		bool enabled() const { return values[0] != 0; }
+	};
+
+	// Returned for vars an effect doesn't declare
+	extern const uint8_t noEffectVar[3];
+
+	template<typename Derived>
+	class EffectClass
+	{
+	public:
+		static constexpr uint8_t flags = EFFECTFLAG_NONE;
+		static constexpr uint8_t targetFps = DEFAULT_TARGET_FPS;
+		static constexpr uint8_t minFps = DEFAULT_MIN_FPS;
+
+		// Hidden by the derived class as needed, calls are resolved at compile time
+		void begin() {}
+		void render(float frameTime) {}
+		void end() {}
+
+		void bind(Effect &effect) { this->effect = &effect; }
+
+	protected:
+		Effect *effect = nullptr;
+
+		const uint8_t *var(VarName name) const
+		{
+			const uint8_t *values = FindEffectVar(*effect, name);
+			return values != nullptr ? values : noEffectVar;
+		}
+
+		ColorVar color(VarName name) const { return ColorVar{ var(name) }; }
+		SliderVar slider(VarName name) const { return SliderVar{ var(name) }; }
+		CheckboxVar checkbox(VarName name) const { return CheckboxVar{ var(name) }; }
+	};
+
+	template<typename... T>
+	struct EffectArenaSize;
+
+	template<>
+	struct EffectArenaSize<>
+	{
+		static constexpr size_t size = 1;
+		static constexpr size_t align = 1;
+	};
+
+	template<typename T, typename... Rest>
+	struct EffectArenaSize<T, Rest...>
+	{
+		static constexpr size_t size = sizeof(T) > EffectArenaSize<Rest...>::size ?
+			sizeof(T) : EffectArenaSize<Rest...>::size;
+		static constexpr size_t align = alignof(T) > EffectArenaSize<Rest...>::align ?
+			alignof(T) : EffectArenaSize<Rest...>::align;
+	};
+
+	// Index + 1 of T in the list, 0 if it is missing
+	template<typename T, typename... List>
+	struct EffectClassIndex
+	{
+		static constexpr uint8_t value = 0;
+	};
+
+	template<typename T, typename... Rest>
+	struct EffectClassIndex<T, T, Rest...>
+	{
+		static constexpr uint8_t value = 1;
+	};
+
+	template<typename T, typename U, typename... Rest>
+	struct EffectClassIndex<T, U, Rest...>
+	{
+		static constexpr uint8_t value = EffectClassIndex<T, Rest...>::value == 0 ?
+			0 : EffectClassIndex<T, Rest...>::value + 1;
+	};
+
+	// True when T declares render(const FixedFrameTime &)
+	template<typename T>
+	struct HasFixedRender
+	{
+		template<typename U>
+		static char Check(decltype(static_cast<U*>(nullptr)->render(*static_cast<const FixedFrameTime*>(nullptr))) *);
+
+		template<typename U>
+		static long Check(...);
+
+		static constexpr bool value = sizeof(Check<T>(nullptr)) == 1;
+	};
+
+	template<typename T, bool fixed = HasFixedRender<T>::value>
+	struct EffectClassRenderer
+	{
+		static void Render(T &instance, float frameTime, const FixedFrameTime &time)
+		{
+			instance.render(frameTime);
+		}
+	};
+
+	template<typename T>
+	struct EffectClassRenderer<T, true>
+	{
+		static void Render(T &instance, float frameTime, const FixedFrameTime &time)
+		{
+			instance.render(time);
+		}
+	};
+
+	template<typename T, typename Arena>
+	inline T *GetEffectInstance()
+	{
+		return reinterpret_cast<T*>(Arena::storage);
+	}
+
+	// Compare chain over the class list, the class methods are inlined into it
+	template<typename Arena, typename... T>
+	struct EffectClassList;
+
+	template<typename Arena>
+	struct EffectClassList<Arena>
+	{
+		static void Begin(uint8_t index, Effect &effect) {}
+		static void Render(uint8_t index, float frameTime, const FixedFrameTime &time) {}
+		static void End(uint8_t index, Effect &effect) {}
+	};
+
+	template<typename Arena, typename T, typename... Rest>
+	struct EffectClassList<Arena, T, Rest...>
+	{
+		typedef EffectClassList<Arena, Rest...> Next;
+
+		static void Begin(uint8_t index, Effect &effect)
+		{
+			if (index != 0)
+			{
+				Next::Begin(index - 1, effect);
+				return;
+			}
+
+			T *instance = new (Arena::storage) T();
+			instance->bind(effect);
+			instance->begin();
+		}
+
+		static void Render(uint8_t index, float frameTime, const FixedFrameTime &time)
+		{
+			if (index != 0)
+			{
+				Next::Render(index - 1, frameTime, time);
+				return;
+			}
+
+			EffectClassRenderer<T>::Render(*GetEffectInstance<T, Arena>(), frameTime, time);
+		}
+
+		static void End(uint8_t index, Effect &effect)
+		{
+			if (index != 0)
+			{
+				Next::End(index - 1, effect);
+				return;
+			}
+
+			T *instance = GetEffectInstance<T, Arena>();
+			instance->end();
+			instance->~T();
+		}
+	};
+
+	// Storage shared by all effect classes, only the active one lives in it
+	template<typename... T>
+	struct EffectArena
+	{
+		static constexpr size_t size = EffectArenaSize<T...>::size;
+		static constexpr size_t align = EffectArenaSize<T...>::align;
+
+		alignas(align) static uint8_t storage[size];
+
+		typedef EffectClassList<EffectArena<T...>, T...> List;
+		static const EffectClassDispatch dispatch;
+
+		template<typename U>
+		struct IndexOf
+		{
+			static constexpr uint8_t value = EffectClassIndex<U, T...>::value;
+			static_assert(value != 0, "Effect class is missing from GIZMOLED_EFFECT_ARENA");
+		};
+	};
+
+	template<typename... T>
+	alignas(EffectArena<T...>::align) uint8_t EffectArena<T...>::storage[EffectArena<T...>::size];
+
+	template<typename... T>
+	const EffectClassDispatch EffectArena<T...>::dispatch =
+	{
+		&EffectArena<T...>::List::Begin,
+		&EffectArena<T...>::List::Render,
+		&EffectArena<T...>::List::End,
+	};
+
+	template<typename Arena>
+	struct EffectClassRegistration
+	{
+		EffectClassRegistration()
+		{
+			effectClassDispatch = &Arena::dispatch;
+		}
+	};
+}
+
+#define GIZMOLED_EFFECT_ARENA(...) \
+	typedef GizmoLED::EffectArena<__VA_ARGS__> GizmoLEDEffectArena; \
+	static GizmoLED::EffectClassRegistration<GizmoLEDEffectArena> gizmoLEDEffectClassRegistration
+
+#define DECLARE_EFFECT_CLASS(variableName, effectClass, type) \
+	DECLARE_EFFECT_ENTRY(variableName, type, nullptr, nullptr, \
+		GizmoLEDEffectArena::IndexOf<effectClass>::value, \
+		effectClass::flags, effectClass::targetFps, effectClass::minFps)
@@ -0,0 +1,105 @@
+#include <ArduinoBLE.h>
+#include <colorpalette.h>
+
+#include "harness.h"
+
+using namespace GizmoLED;
+
+#define NUM_LEDS 300
+
+uint8_t rainbowSettings[] = {
+	VARTYPE_CHECKBOX, VARNAME_RAINBOWENABLED, 1,
+	VARTYPE_SLIDER, VARNAME_RAINBOWLENGTH, 100, 0, 100,
+	VARTYPE_SLIDER, VARNAME_RAINBOWOFFSET, 0, 0, 100,
+};
+
+uint8_t gradientSettings[] = {
+	VARTYPE_COLOR, VARNAME_COLOR1, 255, 0, 0,
+	VARTYPE_COLOR, VARNAME_COLOR2, 0, 255, 0,
+	VARTYPE_COLOR, VARNAME_COLOR3, 0, 0, 255,
+	VARTYPE_SLIDER, VARNAME_NUMBEROFCOLORS, 3, 1, 3,
+};
+
+uint8_t frame[NUM_LEDS * 3];
+Palette palette;
+
+Effect MakeEffect(uint8_t *settings, uint8_t size)
+{
+	Effect effect = {};
+	effect.settings = settings;
+	effect.settingsSize = size;
+	return effect;
+}
+
+// What rainbow effects do without the cache
+void RainbowPerPixel(float scroll)
+{
+	for (int i = 0; i < NUM_LEDS; ++i)
+	{
+		float hue = (scroll + float(i) / NUM_LEDS) * 360.0f;
+		hue -= floor(hue / 360.0f) * 360.0f;
+		HSV2RGB(hue, 100.0f, 100.0f, frame + i * 3);
+	}
+}
+
+// Cyclic three color gradient with float blending
+void GradientPerPixel(float scroll)
+{
+	const uint8_t *colors[] = { gradientSettings + 2, gradientSettings + 7, gradientSettings + 12 };
+	for (int i = 0; i < NUM_LEDS; ++i)
+	{
+		float position = (scroll + float(i) / NUM_LEDS) * 3.0f;
+		position -= floor(position / 3.0f) * 3.0f;
+		const int index = int(position);
+		const float f = position - index;
+		const uint8_t *a = colors[index];
+		const uint8_t *b = colors[(index + 1) % 3];
+		for (int c = 0; c < 3; ++c)
+		{
+			frame[i * 3 + c] = uint8_t(a[c] * (1.0f - f) + b[c] * f);
+		}
+	}
+}
+
+void SamplePalette(uint16_t scroll)
+{
+	for (int i = 0; i < NUM_LEDS; ++i)
+	{
+		const uint16_t position = scroll + uint16_t(i * 65536UL / NUM_LEDS);
+		PaletteSampleOffset(palette, position, frame + i * 3);
+	}
+}
+
+int main()
+{
+	printf("Palette cache vs per pixel colors, %d LEDs per frame\n", NUM_LEDS);
+
+	const Effect rainbow = MakeEffect(rainbowSettings, sizeof rainbowSettings);
+	const Effect gradient = MakeEffect(gradientSettings, sizeof gradientSettings);
+
+	float scroll = 0.0f;
+	uint16_t scrollQ16 = 0;
+
+	const double rainbowHsv = BenchRun([&]() { RainbowPerPixel(scroll += 0.001f); BenchUse(frame); });
+	BenchReport("rainbow, HSV2RGB per pixel", rainbowHsv, NUM_LEDS, "pixels");
+
+	BakePalette(palette, rainbow);
+	const double rainbowPalette = BenchRun([&]() { SamplePalette(scrollQ16 += 64); BenchUse(frame); });
+	BenchReport("rainbow, palette sample", rainbowPalette, NUM_LEDS, "pixels");
+
+	const double gradientFloat = BenchRun([&]() { GradientPerPixel(scroll += 0.001f); BenchUse(frame); });
+	BenchReport("gradient, float blend per pixel", gradientFloat, NUM_LEDS, "pixels");
+
+	BakePalette(palette, gradient);
+	const double gradientPalette = BenchRun([&]() { SamplePalette(scrollQ16 += 64); BenchUse(frame); });
+	BenchReport("gradient, palette sample", gradientPalette, NUM_LEDS, "pixels");
+
+	const double bakeRainbow = BenchRun([&]() { BakePalette(palette, rainbow); BenchUse(&palette); });
+	BenchReport("rainbow bake, only after a settings write", bakeRainbow, PALETTE_SIZE, "entries");
+
+	const double bakeGradient = BenchRun([&]() { BakePalette(palette, gradient); BenchUse(&palette); });
+	BenchReport("gradient bake, only after a settings write", bakeGradient, PALETTE_SIZE, "entries");
+
+	printf("speedup: rainbow %.1fx, gradient %.1fx\n", rainbowHsv / rainbowPalette, gradientFloat / gradientPalette);
+	return 0;
+}
@@ -0,0 +1,126 @@
+#include <ArduinoBLE.h>
+#include <fixedmath.h>
+
+#include "harness.h"
+
+// Float effect math against the fixed point kit. The host has a fast FPU, on the
+// ESP32 and nRF52840 sinf and float division cost far more relative to integer ops.
+
+using namespace GizmoLED;
+
+#define NUM_LEDS 300
+
+uint8_t frame[NUM_LEDS * 3];
+uint8_t colorA[3] = { 255, 40, 0 };
+uint8_t colorB[3] = { 0, 80, 255 };
+
+int main()
+{
+	printf("Effect math, %d LEDs per call\n", NUM_LEDS);
+
+	float time = 0.0f;
+	double ns = BenchRun([&]()
+	{
+		time += 0.016f;
+		for (int i = 0; i < NUM_LEDS; ++i)
+		{
+			frame[i] = uint8_t(sinf(time * 2.0f * PI + i * 0.05f) * 127.5f + 127.5f);
+		}
+		BenchUse(frame);
+	});
+	BenchReport("wave float sinf", ns, NUM_LEDS, "pixels");
+
+	uint16_t phase = 0;
+	ns = BenchRun([&]()
+	{
+		phase += 1049;
+		for (int i = 0; i < NUM_LEDS; ++i)
+		{
+			frame[i] = Sin8((phase >> 8) + i * 2);
+		}
+		BenchUse(frame);
+	});
+	BenchReport("wave Sin8", ns, NUM_LEDS, "pixels");
+
+	float brightness = 0.5f;
+	ns = BenchRun([&]()
+	{
+		brightness = brightness > 0.99f ? 0.0f : brightness + 0.01f;
+		for (int i = 0; i < NUM_LEDS * 3; ++i)
+		{
+			frame[i] = uint8_t(colorA[i % 3] * brightness);
+		}
+		BenchUse(frame);
+	});
+	BenchReport("scale float", ns, NUM_LEDS, "pixels");
+
+	uint8_t scale = 128;
+	ns = BenchRun([&]()
+	{
+		++scale;
+		for (int i = 0; i < NUM_LEDS * 3; ++i)
+		{
+			frame[i] = Scale8(colorA[i % 3], scale);
+		}
+		BenchUse(frame);
+	});
+	BenchReport("scale Scale8", ns, NUM_LEDS, "pixels");
+
+	ns = BenchRun([&]()
+	{
+		for (int i = 0; i < NUM_LEDS; ++i)
+		{
+			const float t = float(i) / (NUM_LEDS - 1);
+			for (int c = 0; c < 3; ++c)
+			{
+				frame[i * 3 + c] = uint8_t(colorA[c] + (colorB[c] - colorA[c]) * t);
+			}
+		}
+		BenchUse(frame);
+	});
+	BenchReport("gradient float lerp", ns, NUM_LEDS, "pixels");
+
+	ns = BenchRun([&]()
+	{
+		for (int i = 0; i < NUM_LEDS; ++i)
+		{
+			const uint8_t t = i * 255 / (NUM_LEDS - 1);
+			for (int c = 0; c < 3; ++c)
+			{
+				frame[i * 3 + c] = Lerp8(colorA[c], colorB[c], t);
+			}
+		}
+		BenchUse(frame);
+	});
+	BenchReport("gradient Lerp8", ns, NUM_LEDS, "pixels");
+
+	// Whole pulse effect: eased brightness from the frame time, applied to every pixel
+	float pulseTime = 0.0f;
+	ns = BenchRun([&]()
+	{
+		pulseTime += 0.016f;
+		const float wave = sinf(pulseTime * 2.0f * PI * 0.5f) * 0.5f + 0.5f;
+		const float eased = wave * wave * (3.0f - 2.0f * wave);
+		for (int i = 0; i < NUM_LEDS * 3; ++i)
+		{
+			frame[i] = uint8_t(colorA[i % 3] * eased);
+		}
+		BenchUse(frame);
+	});
+	BenchReport("pulse effect float", ns, NUM_LEDS, "pixels");
+
+	FixedFrameTime frameTime = { 0, 1049, 0 };
+	ns = BenchRun([&]()
+	{
+		frameTime.phase += frameTime.delta;
+		const uint8_t wave = Sin8(GetPhase16(frameTime, 32768) >> 8);
+		const uint8_t eased = Ease8InOutCubic(wave);
+		for (int i = 0; i < NUM_LEDS * 3; ++i)
+		{
+			frame[i] = Scale8(colorA[i % 3], eased);
+		}
+		BenchUse(frame);
+	});
+	BenchReport("pulse effect fixed", ns, NUM_LEDS, "pixels");
+	return 0;
+}
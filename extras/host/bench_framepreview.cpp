@@ -0,0 +1,56 @@
+#include <ArduinoBLE.h>
+#include <framepreview.h>
+
+#include "harness.h"
+#include "testanimations.h"
+
+using namespace GizmoLED;
+
+#define MAX_LEDS 600
+#define NUM_FRAMES 64
+
+uint8_t frames[NUM_FRAMES][MAX_LEDS * 3];
+
+int main()
+{
+	printf("Preview encoder cost per frame, %d points\n", PREVIEW_MAX_POINTS);
+
+	const int ledCounts[] = { 60, 300, 600 };
+	for (int numLeds : ledCounts)
+	{
+		for (int animation = 0; animation < NUM_TESTANIMATIONS; ++animation)
+		{
+			for (int f = 0; f < NUM_FRAMES; ++f)
+			{
+				if (f > 0)
+				{
+					memcpy(frames[f], frames[f - 1], numLeds * 3);
+				}
+				RenderTestAnimation(animation, f, frames[f], numLeds);
+			}
+
+			PreviewEncoder encoder;
+			PreviewReset(encoder);
+			size_t bytes = 0;
+			uint8_t packet[PREVIEW_MAX_PACKET];
+			for (int f = 0; f < NUM_FRAMES; ++f)
+			{
+				bytes += PreviewEncode(encoder, frames[f], numLeds, PREVIEW_MAX_POINTS, packet);
+			}
+
+			int f = 0;
+			const double ns = BenchRun([&]()
+			{
+				PreviewEncode(encoder, frames[f], numLeds, PREVIEW_MAX_POINTS, packet);
+				BenchUse(packet);
+				f = (f + 1) % NUM_FRAMES;
+			});
+
+			char name[64];
+			snprintf(name, sizeof name, "%d LEDs %s (%.1f bytes/frame)", numLeds,
+				GetTestAnimationName(animation), double(bytes) / NUM_FRAMES);
+			BenchReport(name, ns, numLeds, "pixels");
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,77 @@
+#include <ArduinoBLE.h>
+#include <framestream.h>
+
+#include "harness.h"
+#include "streamencoder.h"
+#include "testanimations.h"
+
+using namespace GizmoLED;
+
+#define NUM_LEDS 300
+#define NUM_FRAMES 120
+#define KEYFRAME_INTERVAL 30
+
+StreamDecoder decoder;
+uint8_t frame[NUM_LEDS * 3];
+
+int main()
+{
+	printf("Frame stream, %d LEDs, %d frames with a keyframe every %d, %d byte packets\n",
+		NUM_LEDS, NUM_FRAMES, KEYFRAME_INTERVAL, STREAM_MAX_PACKET);
+	printf("%-20s %10s %10s %10s\n", "animation", "bytes", "ratio", "packets");
+
+	for (int palette = 0; palette < 2; ++palette)
+	{
+		for (int animation = 0; animation < NUM_TESTANIMATIONS; ++animation)
+		{
+			StreamEncoder encoder;
+			if (palette)
+			{
+				encoder.palette = GetTestRainbowPalette();
+				encoder.paletteSize = 256;
+			}
+
+			// Encode once, the packets are replayed for the decoder timing
+			std::vector<std::vector<uint8_t>> packets = StreamEncodePalette(encoder);
+			const size_t firstFrame = packets.size();
+			size_t paletteBytes = 0;
+			for (const std::vector<uint8_t> &packet : packets)
+			{
+				paletteBytes += packet.size();
+			}
+			size_t bytes = 0;
+			uint8_t source[NUM_LEDS * 3];
+			for (int f = 0; f < NUM_FRAMES; ++f)
+			{
+				RenderTestAnimation(animation, f, source, NUM_LEDS);
+				for (const std::vector<uint8_t> &packet : StreamEncodeFrame(encoder, source, NUM_LEDS, f % KEYFRAME_INTERVAL == 0))
+				{
+					packets.push_back(packet);
+					bytes += packet.size();
+				}
+			}
+
+			char name[64];
+			snprintf(name, sizeof name, "%s%s", GetTestAnimationName(animation), palette ? " +palette" : "");
+			const double raw = double(NUM_LEDS) * 3 * NUM_FRAMES;
+			printf("%-20s %10zu %9.1f%% %10zu", name, bytes, bytes * 100.0 / raw, packets.size() - firstFrame);
+			if (palette)
+			{
+				printf("   (+%zu bytes palette once)", paletteBytes);
+			}
+			printf("\n");
+
+			const double ns = BenchRun([&]()
+			{
+				StreamReset(decoder);
+				for (const std::vector<uint8_t> &packet : packets)
+				{
+					StreamDecodePacket(decoder, packet.data(), packet.size(), frame, NUM_LEDS);
+				}
+				BenchUse(frame);
+			});
+			BenchReport("  decode", ns / NUM_FRAMES, NUM_LEDS, "pixels");
+		}
+	}
+	return 0;
+}
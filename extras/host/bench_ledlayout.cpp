@@ -0,0 +1,55 @@
+#include <ArduinoBLE.h>
+#include <ledlayout.h>
+
+#include "harness.h"
+
+using namespace GizmoLED;
+
+#define NUM_LEDS 300
+
+uint8_t position[NUM_LEDS];
+
+// What angle based effects do without a layout: trig per LED and frame
+void ProjectFloat(float angle)
+{
+	const float dx = cos(angle);
+	const float dy = sin(angle);
+	for (int i = 0; i < NUM_LEDS; ++i)
+	{
+		const float a = float(i) / NUM_LEDS * 2.0f * PI;
+		const float p = cos(a) * dx + sin(a) * dy;
+		position[i] = uint8_t((p + 1.0f) * 127.5f);
+	}
+}
+
+int main()
+{
+	printf("LED positions along VARNAME_ANGLE on a %d LED ring\n", NUM_LEDS);
+
+	Layout layout;
+	LayoutRing(layout, NUM_LEDS);
+
+	float angle = 0.0f;
+	const double trig = BenchRun([&]() { ProjectFloat(angle += 0.01f); BenchUse(position); });
+	BenchReport("sin/cos per LED", trig, NUM_LEDS, "LEDs");
+
+	const double lookup = BenchRun([&]() { BenchUse(GetLayoutProjection(layout, 40)); });
+	BenchReport("layout projection, angle unchanged", lookup, NUM_LEDS, "LEDs");
+
+	uint8_t layoutAngle = 0;
+	const double rebuild = BenchRun([&]() { BenchUse(GetLayoutProjection(layout, ++layoutAngle)); });
+	BenchReport("layout projection, new angle every frame", rebuild, NUM_LEDS, "LEDs");
+
+	const double bake = BenchRun([&]()
+	{
+		const size_t mark = ArenaMark();
+		Layout temp;
+		LayoutRing(temp, NUM_LEDS);
+		BenchUse(&temp);
+		ArenaRelease(mark);
+	});
+	BenchReport("LayoutRing bake, once at setup", bake, NUM_LEDS, "LEDs");
+
+	printf("speedup: %.1fx with a rotating angle, %.0fx for a fixed angle\n", trig / rebuild, trig / lookup);
+	return 0;
+}
@@ -0,0 +1,61 @@
+#include <ArduinoBLE.h>
+#include <ledoutput.h>
+
+#include "harness.h"
+
+using namespace GizmoLED;
+
+#define NUM_LEDS 300
+
+uint8_t frame[NUM_LEDS * 3];
+uint8_t output[NUM_LEDS * 3];
+
+// What effects do today: float brightness per channel, no gamma
+void ScaleFloat(float brightness)
+{
+	for (int i = 0; i < NUM_LEDS * 3; ++i)
+	{
+		output[i] = uint8_t(frame[i] * brightness);
+	}
+}
+
+// Gamma and brightness in float per channel
+void GammaFloat(float brightness)
+{
+	for (int i = 0; i < NUM_LEDS * 3; ++i)
+	{
+		output[i] = uint8_t(powf(frame[i] / 255.0f, float(OUTPUT_GAMMA)) * brightness * 255.0f + 0.5f);
+	}
+}
+
+int main()
+{
+	printf("Output stage, %d LEDs (%d bytes) per frame\n", NUM_LEDS, NUM_LEDS * 3);
+
+	for (int i = 0; i < NUM_LEDS * 3; ++i)
+	{
+		frame[i] = uint8_t(i * 7);
+	}
+
+	SetOutputBrightness(100);
+
+	SetOutputDithering(false);
+	const double lut = BenchRun([]() { ApplyOutput(frame, output, sizeof frame); BenchUse(output); });
+	BenchReport("ApplyOutput, gamma + brightness", lut, sizeof frame, "B");
+
+	SetOutputDithering(true);
+	const double dithered = BenchRun([]() { ApplyOutput(frame, output, sizeof frame); BenchUse(output); });
+	BenchReport("ApplyOutput, gamma + brightness + dithering", dithered, sizeof frame, "B");
+
+	const double inPlace = BenchRun([]() { ApplyOutput(output, output, sizeof output); BenchUse(output); });
+	BenchReport("ApplyOutput in place", inPlace, sizeof frame, "B");
+
+	const double scale = BenchRun([]() { ScaleFloat(0.4f); BenchUse(output); });
+	BenchReport("float brightness, no gamma", scale, sizeof frame, "B");
+
+	const double gamma = BenchRun([]() { GammaFloat(0.4f); BenchUse(output); });
+	BenchReport("float gamma + brightness", gamma, sizeof frame, "B");
+
+	printf("ApplyOutput vs float gamma: %.1fx faster\n", gamma / dithered);
+	return 0;
+}
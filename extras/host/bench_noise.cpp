@@ -0,0 +1,79 @@
+#include <ArduinoBLE.h>
+#include <noise.h>
+
+#include "harness.h"
+
+using namespace GizmoLED;
+
+#define NUM_LEDS 300
+
+uint8_t values[NUM_LEDS];
+
+// Float value noise the way effects write it by hand
+float FloatValueNoise(float x)
+{
+	const int i = int(floor(x));
+	const float f = x - i;
+	const float fade = f * f * (3.0f - 2.0f * f);
+	const float a = float((uint32_t(i) * 2654435761u) >> 24);
+	const float b = float((uint32_t(i + 1) * 2654435761u) >> 24);
+	return a + (b - a) * fade;
+}
+
+int main()
+{
+	printf("Random and noise values, %d per call\n", NUM_LEDS);
+
+	// Host random() is a plain LCG, on the boards it is far slower than this
+	const double arduino = BenchRun([]()
+	{
+		for (int i = 0; i < NUM_LEDS; ++i)
+		{
+			values[i] = random(256);
+		}
+		BenchUse(values);
+	});
+	BenchReport("random(256) per LED", arduino, NUM_LEDS, "values");
+
+	Random random;
+	RandomSeed(random, 1);
+	const double random8 = BenchRun([&]()
+	{
+		for (int i = 0; i < NUM_LEDS; ++i)
+		{
+			values[i] = Random8(random);
+		}
+		BenchUse(values);
+	});
+	BenchReport("Random8 per LED", random8, NUM_LEDS, "values");
+
+	const double fill = BenchRun([&]() { RandomFill(random, values, NUM_LEDS); BenchUse(values); });
+	BenchReport("RandomFill", fill, NUM_LEDS, "values");
+
+	float t = 0.0f;
+	const double floatNoise = BenchRun([&]()
+	{
+		t += 0.1f;
+		for (int i = 0; i < NUM_LEDS; ++i)
+		{
+			values[i] = uint8_t(FloatValueNoise(t + i * 0.1f));
+		}
+		BenchUse(values);
+	});
+	BenchReport("float value noise 1D", floatNoise, NUM_LEDS, "values");
+
+	uint32_t x = 0;
+	const double value1D = BenchRun([&]() { ValueNoiseFill1D(values, NUM_LEDS, x += 25, 25); BenchUse(values); });
+	BenchReport("ValueNoiseFill1D", value1D, NUM_LEDS, "values");
+
+	const double value2D = BenchRun([&]() { ValueNoiseFill2D(values, NUM_LEDS, x += 25, 1000, 25, 7); BenchUse(values); });
+	BenchReport("ValueNoiseFill2D", value2D, NUM_LEDS, "values");
+
+	const double simplex1D = BenchRun([&]() { SimplexNoiseFill1D(values, NUM_LEDS, x += 25, 25); BenchUse(values); });
+	BenchReport("SimplexNoiseFill1D", simplex1D, NUM_LEDS, "values");
+
+	const double simplex2D = BenchRun([&]() { SimplexNoiseFill2D(values, NUM_LEDS, x += 25, 1000, 25, 7); BenchUse(values); });
+	BenchReport("SimplexNoiseFill2D", simplex2D, NUM_LEDS, "values");
+
+	return 0;
+}
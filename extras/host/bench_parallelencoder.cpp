@@ -0,0 +1,75 @@
+#include <ArduinoBLE.h>
+#include <parallelencoder.h>
+
+#include "harness.h"
+
+// Parallel output encoding against pushing bits one at a time. Built twice by the
+// Makefile, the _scalar build times the portable path the MCUs run.
+
+using namespace GizmoLED;
+
+#define NUM_STRIPS 16
+#define NUM_LEDS 300
+#define NUM_BYTES (NUM_LEDS * 3)
+
+uint8_t stripData[NUM_STRIPS][NUM_BYTES];
+const uint8_t *strips[NUM_STRIPS];
+uint8_t slices[NUM_BYTES * 8 * 2];
+uint8_t expanded[NUM_BYTES * 8 * PARALLEL_WS2812_SLOTS];
+
+// What a bit banging driver does per strip byte
+void NaiveEncode(int numStrips)
+{
+	memset(slices, 0, NUM_BYTES * 8);
+	for (int s = 0; s < numStrips; ++s)
+	{
+		for (int i = 0; i < NUM_BYTES; ++i)
+		{
+			for (int bit = 0; bit < 8; ++bit)
+			{
+				if (strips[s][i] & (0x80 >> bit))
+				{
+					slices[i * 8 + bit] |= 1 << s;
+				}
+			}
+		}
+	}
+}
+
+int main()
+{
+#if defined(__SSE2__) && !defined(PARALLEL_NO_SIMD)
+	printf("Parallel encoder (SSE2), %d LEDs per strip\n", NUM_LEDS);
+#else
+	printf("Parallel encoder (scalar), %d LEDs per strip\n", NUM_LEDS);
+#endif
+
+	for (int s = 0; s < NUM_STRIPS; ++s)
+	{
+		for (int i = 0; i < NUM_BYTES; ++i)
+		{
+			stripData[s][i] = uint8_t(i * 7 + s * 31);
+		}
+		strips[s] = stripData[s];
+	}
+
+	const double naive = BenchRun([]() { NaiveEncode(8); BenchUse(slices); });
+	BenchReport("naive bit loop, 8 strips", naive, NUM_BYTES * 8, "B");
+
+	const double encode = BenchRun([]() { ParallelEncode(strips, 8, NUM_BYTES, slices); BenchUse(slices); });
+	BenchReport("ParallelEncode, 8 strips", encode, NUM_BYTES * 8, "B");
+
+	const double partial = BenchRun([]() { ParallelEncode(strips, 3, NUM_BYTES, slices); BenchUse(slices); });
+	BenchReport("ParallelEncode, 3 strips", partial, NUM_BYTES * 3, "B");
+
+	const double lanes = BenchRun([]() { ParallelEncodeLanes(strips, 16, NUM_BYTES, slices); BenchUse(slices); });
+	BenchReport("ParallelEncodeLanes, 16 strips", lanes, NUM_BYTES * 16, "B");
+
+	const double expand = BenchRun([]() { ParallelExpandWS2812(slices, NUM_BYTES * 8, expanded); BenchUse(expanded); });
+	BenchReport("ParallelExpandWS2812, 8 strips", expand, NUM_BYTES * 8, "slices");
+
+	printf("ParallelEncode vs naive bit loop: %.1fx faster\n", naive / encode);
+	printf("Frame time at 800 kHz, 8 strips: %.0f us output, %.0f us encode + expand\n",
+		NUM_BYTES * 8 * 1.25, (encode + expand) / 1e3);
+	return 0;
+}
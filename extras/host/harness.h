@@ -0,0 +1,100 @@
+#pragma once
+
+// Shared helpers for the host tests, benchmarks and simulations
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <chrono>
+
+// Simulated clock behind millis() and micros()
+extern void HostAdvanceMicros(uint64_t us);
+extern uint64_t HostMicros();
+
+// Tests
+
+extern int hostChecks;
+extern int hostFailures;
+
+#define CHECK(condition) \
+	HostCheck((condition), #condition, __FILE__, __LINE__)
+
+#define CHECK_EQUAL(expected, actual) \
+	HostCheckEqual((long long)(expected), (long long)(actual), #actual, __FILE__, __LINE__)
+
+inline bool HostCheck(bool passed, const char *expression, const char *file, int line)
+{
+	++hostChecks;
+	if (!passed)
+	{
+		++hostFailures;
+		printf("%s:%d: check failed: %s\n", file, line, expression);
+	}
+	return passed;
+}
+
+inline bool HostCheckEqual(long long expected, long long actual, const char *expression, const char *file, int line)
+{
+	++hostChecks;
+	if (expected != actual)
+	{
+		++hostFailures;
+		printf("%s:%d: %s is %lld, expected %lld\n", file, line, expression, actual, expected);
+	}
+	return expected == actual;
+}
+
+// Prints the summary, the result is the exit code of main()
+inline int HostTestResult(const char *name)
+{
+	printf("%s: %d checks, %d failed\n", name, hostChecks, hostFailures);
+	return hostFailures == 0 ? 0 : 1;
+}
+
+// Benchmarks
+
+// Keeps the compiler from optimizing away results that are never read
+inline void BenchUse(const void *value)
+{
+	asm volatile("" : : "r"(value) : "memory");
+}
+
+// Runs fn repeatedly for about 200ms and returns the wall time per call in ns
+template<typename Fn>
+double BenchRun(Fn fn)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	// Warm up caches and find a batch size that is long enough to time
+	long batch = 1;
+	for (;;)
+	{
+		const Clock::time_point start = Clock::now();
+		for (long i = 0; i < batch; ++i)
+		{
+			fn();
+		}
+		const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+		if (elapsed > 0.01)
+			break;
+		batch *= 2;
+	}
+
+	double best = 1e30;
+	for (int round = 0; round < 20; ++round)
+	{
+		const Clock::time_point start = Clock::now();
+		for (long i = 0; i < batch; ++i)
+		{
+			fn();
+		}
+		const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+		best = elapsed < best ? elapsed : best;
+	}
+	return best * 1e9 / batch;
+}
+
+// One result line: time per call and throughput of the items processed per call
+inline void BenchReport(const char *name, double nsPerCall, double itemsPerCall, const char *unit)
+{
+	printf("%-44s %12.1f ns/call %12.2f M%s/s\n", name, nsPerCall, itemsPerCall * 1e3 / nsPerCall, unit);
+}
@@ -0,0 +1,539 @@
+#include <ArduinoBLE.h>
+#include <EEPROM.h>
+#include <utility/ATT.h>
+#include <utility/HCI.h>
+#include <stdio.h>
+
+#include "harness.h"
+
+// Tests
+
+int hostChecks = 0;
+int hostFailures = 0;
+
+// Clock
+
+uint64_t hostMicros = 0;
+
+unsigned long millis()
+{
+	return (unsigned long)(hostMicros / 1000);
+}
+
+unsigned long micros()
+{
+	return (unsigned long)hostMicros;
+}
+
+void delay(unsigned long ms)
+{
+	hostMicros += uint64_t(ms) * 1000;
+}
+
+void delayMicroseconds(unsigned int us)
+{
+	hostMicros += us;
+}
+
+void HostAdvanceMicros(uint64_t us)
+{
+	hostMicros += us;
+}
+
+uint64_t HostMicros()
+{
+	return hostMicros;
+}
+
+// Random
+
+uint32_t hostRandomState = 1;
+
+void randomSeed(unsigned long seed)
+{
+	hostRandomState = seed != 0 ? uint32_t(seed) : 1;
+}
+
+long random(long max)
+{
+	if (max <= 0)
+		return 0;
+
+	hostRandomState = hostRandomState * 1103515245 + 12345;
+	return long((hostRandomState >> 1) % uint32_t(max));
+}
+
+long random(long min, long max)
+{
+	return min >= max ? min : min + random(max - min);
+}
+
+// String
+
+String::String(const char *text) : text(text != nullptr ? text : "") {}
+String::String(const std::string &text) : text(text) {}
+String::String(char c) : text(1, c) {}
+String::String(unsigned char value, unsigned char base) : String((unsigned long)value, base) {}
+String::String(int value, unsigned char base) : String(long(value), base) {}
+String::String(unsigned int value, unsigned char base) : String((unsigned long)value, base) {}
+
+String::String(long value, unsigned char base)
+{
+	if (base == 10 || value >= 0)
+	{
+		*this = value < 0 ? "-" + String((unsigned long)-value, base) : String((unsigned long)value, base);
+	}
+	else
+	{
+		*this = String((unsigned long)value, base);
+	}
+}
+
+String::String(unsigned long value, unsigned char base)
+{
+	char buffer[8 * sizeof(unsigned long) + 1];
+	char *write = buffer + sizeof buffer - 1;
+	*write = 0;
+	do
+	{
+		const int digit = value % base;
+		*--write = digit < 10 ? '0' + digit : 'A' + digit - 10;
+		value /= base;
+	} while (value != 0);
+	text = write;
+}
+
+String::String(float value, unsigned char decimals) : String(double(value), decimals) {}
+
+String::String(double value, unsigned char decimals)
+{
+	char buffer[64];
+	snprintf(buffer, sizeof buffer, "%.*f", decimals, value);
+	text = buffer;
+}
+
+String String::operator+(const String &other) const
+{
+	return String(text + other.text);
+}
+
+String &String::operator+=(const String &other)
+{
+	text += other.text;
+	return *this;
+}
+
+bool String::operator==(const char *other) const
+{
+	return text == other;
+}
+
+unsigned int String::length() const
+{
+	return text.length();
+}
+
+const char *String::c_str() const
+{
+	return text.c_str();
+}
+
+String operator+(const char *a, const String &b)
+{
+	return String(a) + b;
+}
+
+// Serial
+
+HardwareSerial Serial;
+
+void HardwareSerial::begin(unsigned long baud)
+{
+	(void)baud;
+}
+
+void HardwareSerial::setTimeout(unsigned long timeout)
+{
+	(void)timeout;
+}
+
+void HardwareSerial::print(const String &text)
+{
+	print(text.c_str());
+}
+
+void HardwareSerial::print(const char *text)
+{
+	line += text;
+}
+
+void HardwareSerial::print(long value, int base)
+{
+	print(String(value, base));
+}
+
+void HardwareSerial::println(const String &text)
+{
+	println(text.c_str());
+}
+
+void HardwareSerial::println(const char *text)
+{
+	print(text);
+	println();
+}
+
+void HardwareSerial::println(long value, int base)
+{
+	print(value, base);
+	println();
+}
+
+void HardwareSerial::println()
+{
+	if (echo)
+	{
+		printf("%s\n", line.c_str());
+	}
+	snprintf(lastLine, sizeof lastLine, "%s", line.c_str());
+	line.clear();
+}
+
+// EEPROM
+
+EEPROMClass EEPROM;
+
+// BLE
+
+BLELocalDevice BLE;
+
+struct HostReport
+{
+	uint8_t data[HOST_BLE_MAX_ADVERTISEMENT];
+	int length;
+};
+
+HostReport hostReports[HOST_BLE_MAX_REPORTS];
+int hostReportsQueued = 0;
+int hostReportsRead = 0;
+
+BLEDevice::operator bool() const
+{
+	return report >= 0;
+}
+
+bool BLEDevice::connected() const
+{
+	return report < 0 && BLE.isConnected;
+}
+
+String BLEDevice::address() const
+{
+	return String("12:34:56:78:9a:bc");
+}
+
+int BLEDevice::rssi()
+{
+	return -50;
+}
+
+bool BLEDevice::hasManufacturerData() const
+{
+	return report >= 0 && hostReports[report].length > 0;
+}
+
+int BLEDevice::manufacturerDataLength() const
+{
+	return report >= 0 ? hostReports[report].length : 0;
+}
+
+int BLEDevice::manufacturerData(uint8_t *value, int length) const
+{
+	const int count = min(length, manufacturerDataLength());
+	if (count > 0)
+	{
+		memcpy(value, hostReports[report].data, count);
+	}
+	return count;
+}
+
+BLECharacteristic::BLECharacteristic(const char *uuid, uint8_t properties, int valueSize, bool fixedLength)
+{
+	(void)fixedLength;
+	local = new HostCharacteristic();
+	local->uuid = uuid;
+	local->properties = properties;
+	local->valueSize = min(valueSize, HOST_BLE_MAX_VALUE);
+}
+
+const char *BLECharacteristic::uuid() const
+{
+	return local->uuid;
+}
+
+int BLECharacteristic::valueSize() const
+{
+	return local->valueSize;
+}
+
+int BLECharacteristic::valueLength() const
+{
+	return local->valueLength;
+}
+
+const uint8_t *BLECharacteristic::value() const
+{
+	return local->value;
+}
+
+int BLECharacteristic::writeValue(const uint8_t *value, int length, bool withResponse)
+{
+	(void)withResponse;
+	length = min(length, local->valueSize);
+	memcpy(local->value, value, length);
+	local->valueLength = length;
+	++local->writes;
+	return 1;
+}
+
+bool BLECharacteristic::subscribed()
+{
+	return local->subscribed;
+}
+
+void BLECharacteristic::setEventHandler(int event, BLECharacteristicEventHandler handler)
+{
+	if (event >= 0 && event < HOST_BLE_MAX_HANDLERS)
+	{
+		local->handlers[event] = handler;
+	}
+}
+
+BLEService::BLEService(const char *uuid) : serviceUuid(uuid) {}
+
+const char *BLEService::uuid() const
+{
+	return serviceUuid;
+}
+
+void BLEService::addCharacteristic(BLECharacteristic &characteristic)
+{
+	(void)characteristic;
+}
+
+int BLELocalDevice::begin()
+{
+	return 1;
+}
+
+void BLELocalDevice::end()
+{
+}
+
+void BLELocalDevice::poll(unsigned long timeout)
+{
+	// No radio, waiting for events always runs into the timeout
+	delay(timeout);
+}
+
+void BLELocalDevice::setLocalName(const char *name)
+{
+	localName = name;
+}
+
+void BLELocalDevice::setAdvertisedService(const BLEService &service)
+{
+	advertisedService = service.uuid();
+}
+
+bool BLELocalDevice::setManufacturerData(const uint8_t data[], int length)
+{
+	manufacturerData = data;
+	manufacturerDataLength = length;
+	return true;
+}
+
+bool BLELocalDevice::setManufacturerData(uint16_t companyId, const uint8_t data[], int length)
+{
+	(void)companyId;
+	return setManufacturerData(data, length);
+}
+
+void BLELocalDevice::setAdvertisingInterval(uint16_t interval)
+{
+	advertisingInterval = interval;
+}
+
+void BLELocalDevice::setConnectionInterval(uint16_t minInterval, uint16_t maxInterval)
+{
+	minConnectionInterval = minInterval;
+	maxConnectionInterval = maxInterval;
+}
+
+void BLELocalDevice::setSupervisionTimeout(uint16_t timeout)
+{
+	supervisionTimeout = timeout;
+}
+
+int BLELocalDevice::advertise()
+{
+	// Same packet layout as ArduinoBLE: flags, advertised service, manufacturer data.
+	// Fields that don't fit anymore are left out without an error.
+	int length = 0;
+	advertisement[length++] = 2;
+	advertisement[length++] = 0x01;
+	advertisement[length++] = 0x06;
+
+	if (advertisedService != nullptr)
+	{
+		const int uuidLength = strlen(advertisedService) == 36 ? 16 : 2;
+		advertisement[length++] = uuidLength + 1;
+		advertisement[length++] = uuidLength == 16 ? 0x07 : 0x03;
+		memset(advertisement + length, 0, uuidLength);
+		length += uuidLength;
+	}
+
+	if (manufacturerData != nullptr && manufacturerDataLength > 0 && length + 2 + manufacturerDataLength <= HOST_BLE_MAX_ADVERTISEMENT)
+	{
+		advertisement[length++] = manufacturerDataLength + 1;
+		advertisement[length++] = 0xFF;
+		memcpy(advertisement + length, manufacturerData, manufacturerDataLength);
+		length += manufacturerDataLength;
+	}
+
+	advertisementLength = length;
+	advertising = true;
+	++advertiseCalls;
+	return 1;
+}
+
+void BLELocalDevice::stopAdvertise()
+{
+	advertising = false;
+}
+
+int BLELocalDevice::scan(bool withDuplicates)
+{
+	(void)withDuplicates;
+	scanning = true;
+	return 1;
+}
+
+void BLELocalDevice::stopScan()
+{
+	scanning = false;
+}
+
+BLEDevice BLELocalDevice::available()
+{
+	if (!scanning || hostReportsRead >= hostReportsQueued)
+	{
+		hostReportsRead = hostReportsQueued = 0;
+		return BLEDevice();
+	}
+	return BLEDevice(hostReportsRead++);
+}
+
+BLEDevice BLELocalDevice::central()
+{
+	return BLEDevice();
+}
+
+bool BLELocalDevice::connected() const
+{
+	return isConnected;
+}
+
+bool BLELocalDevice::disconnect()
+{
+	HostConnect(false);
+	return true;
+}
+
+void BLELocalDevice::addService(BLEService &service)
+{
+	(void)service;
+}
+
+void BLELocalDevice::setEventHandler(int event, BLEDeviceEventHandler handler)
+{
+	if (event >= 0 && event < BLEDeviceLastEvent)
+	{
+		handlers[event] = handler;
+	}
+}
+
+void HostWrite(BLECharacteristic &characteristic, const uint8_t *value, int length)
+{
+	HostCharacteristic *local = characteristic.local;
+	length = min(length, local->valueSize);
+	memcpy(local->value, value, length);
+	local->valueLength = length;
+
+	if (local->handlers[BLEWritten] != nullptr)
+	{
+		local->handlers[BLEWritten](BLEDevice(), characteristic);
+	}
+}
+
+void HostSubscribe(BLECharacteristic &characteristic, bool subscribed)
+{
+	HostCharacteristic *local = characteristic.local;
+	local->subscribed = subscribed;
+
+	const int event = subscribed ? BLESubscribed : BLEUnsubscribed;
+	if (local->handlers[event] != nullptr)
+	{
+		local->handlers[event](BLEDevice(), characteristic);
+	}
+}
+
+void HostConnect(bool connected)
+{
+	BLE.isConnected = connected;
+
+	const int event = connected ? BLEConnected : BLEDisconnected;
+	if (BLE.handlers[event] != nullptr)
+	{
+		BLE.handlers[event](BLEDevice());
+	}
+}
+
+// ATT and HCI
+
+ATTClass ATT;
+HCIClass HCI;
+
+// Matches the address BLEDevice::address() prints
+const uint8_t hostCentralAddress[6] = { 0xbc, 0x9a, 0x78, 0x56, 0x34, 0x12 };
+
+uint16_t ATTClass::connectionHandle(uint8_t addressType, const uint8_t address[6]) const
+{
+	if (!BLE.isConnected || addressType != HOST_CENTRAL_ADDRESS_TYPE || memcmp(address, hostCentralAddress, 6) != 0)
+		return 0xFFFF;
+
+	return HOST_CONNECTION_HANDLE;
+}
+
+int HCIClass::sendAclPkt(uint16_t handle, uint8_t cid, uint8_t plen, void *data)
+{
+	++aclPackets;
+	lastAclHandle = handle;
+	lastAclCid = cid;
+	lastAclLength = min(int(plen), HOST_HCI_MAX_PACKET);
+	memcpy(lastAcl, data, lastAclLength);
+	return 0;
+}
+
+void HostDiscover(const uint8_t *manufacturerData, int length)
+{
+	if (hostReportsQueued >= HOST_BLE_MAX_REPORTS)
+		return;
+
+	HostReport &report = hostReports[hostReportsQueued++];
+	report.length = min(length, HOST_BLE_MAX_ADVERTISEMENT);
+	memcpy(report.data, manufacturerData, report.length);
+}
+
+// Sketches provide this, tests that don't care get a default
+__attribute__((weak)) const char *defaultDeviceName = "GizmoLED";
@@ -0,0 +1,174 @@
+#include <ArduinoBLE.h>
+#include <clocksync.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "harness.h"
+
+using namespace GizmoLED;
+
+// Multi-node clock sync: one master and several followers with skewed crystals.
+// The master updates its beacon every SYNC_BEACON_INTERVAL, restarts advertising and
+// repeats it every SYNC_ADVERTISING_INTERVAL plus the 0-10ms random advertising delay. Each copy reaches
+// a follower with some probability after a short radio/stack delay, and is only
+// read on the follower's next loop iteration (60Hz on its own clock). Phase error is the follower's
+// mapped phase against the master's true phase, sampled every frame after a settling time.
+
+#define NUM_FOLLOWERS 4
+#define SIM_SECONDS 600
+#define SETTLE_SECONDS 60
+#define FRAME_SECONDS (1.0 / 60.0)
+
+struct Scenario
+{
+	const char *name;
+	double loss; // Per received copy
+	double maxDelay; // Seconds of radio and stack delay on top of 0.5ms
+};
+
+const Scenario scenarios[] =
+{
+	{ "clean", 0.0, 0.002 },
+	{ "30% loss", 0.3, 0.005 },
+	{ "70% loss", 0.7, 0.010 },
+	{ "90% loss", 0.9, 0.020 },
+};
+
+const double skews[NUM_FOLLOWERS] = { 100e-6, -150e-6, 40e-6, 250e-6 };
+const double starts[NUM_FOLLOWERS] = { 1.3, 1000.7, 5.0, 77.2 };
+
+uint32_t Q16(double seconds)
+{
+	return uint32_t(uint64_t(seconds * 65536.0));
+}
+
+struct Copy
+{
+	double arrival; // Master time
+	uint8_t beacon[SYNC_BEACON_SIZE];
+};
+
+void Run(const Scenario &scenario)
+{
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+	ClockSync followers[NUM_FOLLOWERS];
+	std::vector<Copy> inFlight[NUM_FOLLOWERS];
+	std::vector<double> errors[NUM_FOLLOWERS];
+	uint32_t beaconsMissed[NUM_FOLLOWERS] = {};
+	bool beaconSeen[NUM_FOLLOWERS] = {};
+	for (int n = 0; n < NUM_FOLLOWERS; ++n)
+	{
+		ClockSyncReset(followers[n]);
+	}
+
+	uint8_t beacon[SYNC_BEACON_SIZE];
+	uint8_t sequence = 0;
+	double nextBeacon = 0.0;
+	double nextAdvertisement = 0.0;
+	double nextFrame[NUM_FOLLOWERS] = {}; // Local time, each follower runs its own loop
+	const double dt = 0.0005;
+	for (double t = 0.0; t < SIM_SECONDS; t += dt)
+	{
+		if (t >= nextBeacon)
+		{
+			for (int n = 0; n < NUM_FOLLOWERS; ++n)
+			{
+				beaconsMissed[n] += nextBeacon > 0.0 && !beaconSeen[n];
+				beaconSeen[n] = false;
+			}
+			ClockSyncWriteBeacon(beacon, sequence++, Q16(t), 0);
+			nextBeacon += SYNC_BEACON_INTERVAL / 1000.0;
+
+			// Advertising restarts with the new data
+			nextAdvertisement = t;
+		}
+
+		if (t >= nextAdvertisement)
+		{
+			for (int n = 0; n < NUM_FOLLOWERS; ++n)
+			{
+				if (uniform(rng) < scenario.loss)
+					continue;
+
+				// Advertising reports are delivered in order
+				Copy copy;
+				copy.arrival = t + 0.0005 + uniform(rng) * scenario.maxDelay;
+				if (!inFlight[n].empty())
+				{
+					copy.arrival = max(copy.arrival, inFlight[n].back().arrival);
+				}
+				memcpy(copy.beacon, beacon, SYNC_BEACON_SIZE);
+				inFlight[n].push_back(copy);
+				beaconSeen[n] = true;
+			}
+			nextAdvertisement += SYNC_ADVERTISING_INTERVAL * 0.000625 + uniform(rng) * 0.010;
+		}
+
+		// Follower loops, each reads what arrived since its last frame
+		for (int n = 0; n < NUM_FOLLOWERS; ++n)
+		{
+			const double localSeconds = t * (1.0 + skews[n]) + starts[n];
+			if (localSeconds < nextFrame[n])
+				continue;
+
+			nextFrame[n] = localSeconds + FRAME_SECONDS;
+			const uint32_t local = Q16(localSeconds);
+			std::vector<Copy> &copies = inFlight[n];
+			size_t kept = 0;
+			for (size_t c = 0; c < copies.size(); ++c)
+			{
+				if (copies[c].arrival > t)
+				{
+					copies[kept++] = copies[c];
+					continue;
+				}
+
+				uint8_t copySequence, effectName;
+				uint32_t phase;
+				if (ClockSyncReadBeacon(copies[c].beacon, SYNC_BEACON_SIZE, &copySequence, &phase, &effectName))
+				{
+					ClockSyncSample(followers[n], phase, copySequence, local);
+				}
+			}
+			copies.resize(kept);
+
+			if (t > SETTLE_SECONDS)
+			{
+				const int32_t error = int32_t(ClockSyncPhase(followers[n], local) - Q16(t));
+				errors[n].push_back(fabs(error * 1000.0 / 65536.0));
+			}
+		}
+	}
+
+	printf("%s\n", scenario.name);
+	for (int n = 0; n < NUM_FOLLOWERS; ++n)
+	{
+		std::vector<double> &e = errors[n];
+		std::sort(e.begin(), e.end());
+		double mean = 0.0;
+		for (double value : e)
+		{
+			mean += value;
+		}
+		mean /= e.size();
+
+		const ClockSync &sync = followers[n];
+		printf("  follower %d %+6.0fppm: error mean %6.2fms p95 %6.2fms max %6.2fms, drift %+7.1fppm, lost %u (%u)\n",
+			n, skews[n] * 1e6, mean, e[e.size() * 95 / 100], e.back(),
+			-sync.drift / 16.777216, unsigned(sync.lost), unsigned(beaconsMissed[n]));
+	}
+}
+
+int main()
+{
+	printf("Clock sync, %d followers, %ds, error measured after %ds. Lost: counted (actual)\n",
+		NUM_FOLLOWERS, SIM_SECONDS, SETTLE_SECONDS);
+	for (const Scenario &scenario : scenarios)
+	{
+		Run(scenario);
+	}
+	return 0;
+}
@@ -0,0 +1,186 @@
+#include <ArduinoBLE.h>
+#include <utility/HCI.h>
+#include <linkpolicy.h>
+#include <algorithm>
+#include <vector>
+
+#include "harness.h"
+
+// Replays app traffic traces against the adaptive link policy and against each fixed
+// policy. The connection is modeled at 1ms resolution: the central uses the minimum
+// requested interval, the peripheral listens to every (latency + 1)th connection event,
+// and a received write waits for the next BLE poll of the loop (once per frame at 60Hz
+// or every bleUpdateDelay, whichever is longer).
+
+using namespace GizmoLED;
+
+#define FRAME_MICROS 16667
+
+struct Trace
+{
+	const char *name;
+	EffectType type;
+	unsigned long durationMillis;
+
+	// Writes sent by the app in this millisecond
+	int (*writes)(unsigned long millis);
+};
+
+int Every(unsigned long millis, unsigned long period)
+{
+	return millis % period == 0;
+}
+
+int NoWrites(unsigned long millis)
+{
+	return 0;
+}
+
+// Slider drags: 3s at 20 writes/s every 20s for two minutes, then nothing
+int SliderWrites(unsigned long millis)
+{
+	return millis < 120000 && millis % 20000 < 3000 && Every(millis, 50);
+}
+
+int AudioWrites(unsigned long millis)
+{
+	return Every(millis, 33);
+}
+
+int StreamWrites(unsigned long millis)
+{
+	return Every(millis, 25);
+}
+
+const Trace traces[] =
+{
+	{ "idle", EFFECTTYPE_DEFAULT, 300000, NoWrites },
+	{ "sliders", EFFECTTYPE_DEFAULT, 300000, SliderWrites },
+	{ "visualizer", EFFECTTYPE_VISUALIZER, 120000, AudioWrites },
+	{ "stream", EFFECTTYPE_STREAM, 60000, StreamWrites },
+};
+
+struct Result
+{
+	uint32_t radioEvents;
+	uint32_t estimatedEvents; // What the link policy stats would report
+	std::vector<float> latencies; // ms
+};
+
+// policy < 0 replays against the adaptive policy
+Result Replay(const Trace &trace, int policy)
+{
+	Result result = {};
+
+	if (policy < 0)
+	{
+		// Let the smoothed write rate of the previous trace decay
+		for (int i = 0; i < 10; ++i)
+		{
+			HostAdvanceMicros(1000000);
+			UpdateLinkPolicy(trace.type);
+		}
+		BeginLinkPolicy(trace.type);
+		UpdateLinkPolicy(trace.type, true);
+	}
+
+	const uint32_t estimatedStart = policy < 0 ? GetLinkPolicyStats(LINKPOLICY_IDLE).radioEvents +
+		GetLinkPolicyStats(LINKPOLICY_INTERACTIVE).radioEvents + GetLinkPolicyStats(LINKPOLICY_REALTIME).radioEvents : 0;
+
+	std::vector<unsigned long> pending;
+	unsigned long nextEventMicros = 0;
+	uint32_t eventIndex = 0;
+	for (unsigned long ms = 0; ms < trace.durationMillis; ++ms)
+	{
+		const LinkPolicy &parameters = policy < 0 ? GetLinkParameters() : linkPolicies[policy];
+		const LinkPolicy &loop = policy < 0 ? GetLinkPolicy() : linkPolicies[policy];
+		const unsigned long now = ms * 1000;
+
+		for (int w = trace.writes(ms); w > 0; --w)
+		{
+			pending.push_back(now);
+			if (policy < 0)
+			{
+				LinkPolicyNotifyWrite();
+			}
+		}
+
+		while (nextEventMicros < now + 1000)
+		{
+			if (eventIndex++ % (parameters.latency + 1) == 0)
+			{
+				++result.radioEvents;
+
+				const unsigned long pollMicros = max((unsigned long)(loop.bleUpdateDelay * 1000000), (unsigned long)FRAME_MICROS);
+				const unsigned long pollAt = (nextEventMicros + pollMicros - 1) / pollMicros * pollMicros;
+				for (unsigned long sent : pending)
+				{
+					result.latencies.push_back((pollAt - sent) / 1000.0f);
+				}
+				pending.clear();
+			}
+			nextEventMicros += parameters.minInterval * 1250UL;
+		}
+
+		HostAdvanceMicros(1000);
+		if (policy < 0)
+		{
+			UpdateLinkPolicy(trace.type);
+		}
+	}
+
+	if (policy >= 0)
+	{
+		result.estimatedEvents = EstimateRadioEvents(linkPolicies[policy], true, trace.durationMillis);
+	}
+	else
+	{
+		result.estimatedEvents = GetLinkPolicyStats(LINKPOLICY_IDLE).radioEvents +
+			GetLinkPolicyStats(LINKPOLICY_INTERACTIVE).radioEvents +
+			GetLinkPolicyStats(LINKPOLICY_REALTIME).radioEvents - estimatedStart;
+	}
+	return result;
+}
+
+void Report(const Trace &trace, const char *policyName, Result &result)
+{
+	float mean = 0.0f, p95 = 0.0f, worst = 0.0f;
+	if (!result.latencies.empty())
+	{
+		std::sort(result.latencies.begin(), result.latencies.end());
+		for (float latency : result.latencies)
+		{
+			mean += latency;
+		}
+		mean /= result.latencies.size();
+		p95 = result.latencies[result.latencies.size() * 95 / 100];
+		worst = result.latencies.back();
+	}
+
+	printf("%-12s %-12s %10.1f %10.1f %10.1f %10.1f %10.1f\n", trace.name, policyName,
+		result.radioEvents * 1000.0f / trace.durationMillis,
+		result.estimatedEvents * 1000.0f / trace.durationMillis, mean, p95, worst);
+}
+
+int main()
+{
+	const char *policyNames[NUM_LINKPOLICIES] = { "fixed idle", "fixed inter.", "fixed realt." };
+
+	HostConnect(true);
+	LinkPolicyConnected(BLEDevice());
+
+	printf("Link policy trace replay, radio events per second and write latency in ms\n");
+	printf("%-12s %-12s %10s %10s %10s %10s %10s\n", "trace", "policy", "events/s", "estimate", "mean", "p95", "max");
+	for (const Trace &trace : traces)
+	{
+		Result adaptive = Replay(trace, -1);
+		Report(trace, "adaptive", adaptive);
+		for (int policy = 0; policy < NUM_LINKPOLICIES; ++policy)
+		{
+			Result fixed = Replay(trace, policy);
+			Report(trace, policyNames[policy], fixed);
+		}
+	}
+	printf("%u connection parameter update requests sent\n", unsigned(HCI.aclPackets));
+	return 0;
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+// Reference encoder for the frame stream format, playing the part of the phone app
+
+#include <ArduinoBLE.h>
+#include <framestream.h>
+#include <vector>
+
+struct StreamEncoder
+{
+	uint8_t sequence = 0;
+	std::vector<uint8_t> previous;
+
+	// Optional palette for indexed ops, colors found in it are sent as one byte
+	const uint8_t (*palette)[3] = nullptr;
+	int paletteSize = 0;
+};
+
+inline bool StreamSamePixel(const uint8_t *a, const uint8_t *b)
+{
+	return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+}
+
+inline int StreamPaletteIndex(const StreamEncoder &encoder, const uint8_t *rgb)
+{
+	for (int i = 0; i < encoder.paletteSize; ++i)
+	{
+		if (StreamSamePixel(encoder.palette[i], rgb))
+			return i;
+	}
+	return -1;
+}
+
+// Ops for one frame, unchanged pixels are skipped unless keyframe is set
+inline std::vector<uint8_t> StreamEncodeOps(StreamEncoder &encoder, const uint8_t *frame, int numPixels, bool keyframe)
+{
+	std::vector<uint8_t> ops;
+	const bool delta = !keyframe && int(encoder.previous.size()) == numPixels * 3;
+
+	int i = 0;
+	while (i < numPixels)
+	{
+		const uint8_t *pixel = frame + i * 3;
+
+		int count = 0;
+		if (delta)
+		{
+			while (i + count < numPixels && count < STREAM_OP_MAX_PIXELS &&
+				StreamSamePixel(frame + (i + count) * 3, &encoder.previous[(i + count) * 3]))
+			{
+				++count;
+			}
+			if (count > 0)
+			{
+				ops.push_back(GizmoLED::STREAMOP_SKIP | (count - 1));
+				i += count;
+				continue;
+			}
+		}
+
+		count = 1;
+		while (i + count < numPixels && count < STREAM_OP_MAX_PIXELS &&
+			StreamSamePixel(frame + (i + count) * 3, pixel))
+		{
+			++count;
+		}
+		if (count >= 2)
+		{
+			ops.push_back(GizmoLED::STREAMOP_RUN | (count - 1));
+			ops.insert(ops.end(), pixel, pixel + 3);
+			i += count;
+			continue;
+		}
+
+		// Literal or indexed pixels until a skip or run would be cheaper
+		const bool indexed = StreamPaletteIndex(encoder, pixel) >= 0;
+		count = 0;
+		while (i + count < numPixels && count < STREAM_OP_MAX_PIXELS)
+		{
+			const uint8_t *p = frame + (i + count) * 3;
+			if (count > 0 && delta && StreamSamePixel(p, &encoder.previous[(i + count) * 3]))
+				break;
+			if (count > 0 && i + count + 1 < numPixels && StreamSamePixel(p, p + 3))
+				break;
+			if ((StreamPaletteIndex(encoder, p) >= 0) != indexed)
+				break;
+			++count;
+		}
+
+		ops.push_back((indexed ? GizmoLED::STREAMOP_INDEXED : GizmoLED::STREAMOP_LITERAL) | (count - 1));
+		for (int c = 0; c < count; ++c)
+		{
+			const uint8_t *p = frame + (i + c) * 3;
+			if (indexed)
+			{
+				ops.push_back(StreamPaletteIndex(encoder, p));
+			}
+			else
+			{
+				ops.insert(ops.end(), p, p + 3);
+			}
+		}
+		i += count;
+	}
+
+	encoder.previous.assign(frame, frame + numPixels * 3);
+	return ops;
+}
+
+// Splits ops into packets of at most maxPacket bytes including the header
+inline std::vector<std::vector<uint8_t>> StreamPacketize(StreamEncoder &encoder, const std::vector<uint8_t> &ops,
+	bool keyframe, int maxPacket = STREAM_MAX_PACKET)
+{
+	std::vector<std::vector<uint8_t>> packets;
+	const int payload = maxPacket - 2;
+	size_t pos = 0;
+	do
+	{
+		const size_t count = std::min(ops.size() - pos, size_t(payload));
+		uint8_t flags = 0;
+		if (pos == 0)
+		{
+			flags |= GizmoLED::STREAMPACKET_FRAMESTART | (keyframe ? GizmoLED::STREAMPACKET_KEYFRAME : 0);
+		}
+		if (pos + count == ops.size())
+		{
+			flags |= GizmoLED::STREAMPACKET_FRAMEEND;
+		}
+
+		std::vector<uint8_t> packet;
+		packet.push_back(flags);
+		packet.push_back(encoder.sequence++);
+		packet.insert(packet.end(), ops.begin() + pos, ops.begin() + pos + count);
+		packets.push_back(packet);
+		pos += count;
+	} while (pos < ops.size());
+	return packets;
+}
+
+inline std::vector<std::vector<uint8_t>> StreamEncodeFrame(StreamEncoder &encoder, const uint8_t *frame, int numPixels,
+	bool keyframe, int maxPacket = STREAM_MAX_PACKET)
+{
+	return StreamPacketize(encoder, StreamEncodeOps(encoder, frame, numPixels, keyframe), keyframe, maxPacket);
+}
+
+// Palette packets for the decoder, sent before frames that use indexed ops
+inline std::vector<std::vector<uint8_t>> StreamEncodePalette(StreamEncoder &encoder)
+{
+	std::vector<std::vector<uint8_t>> packets;
+	const int perPacket = (STREAM_MAX_PACKET - 3) / 3;
+	for (int start = 0; start < encoder.paletteSize; start += perPacket)
+	{
+		std::vector<uint8_t> packet;
+		packet.push_back(GizmoLED::STREAMPACKET_PALETTE);
+		packet.push_back(encoder.sequence++);
+		packet.push_back(start);
+		for (int i = start; i < std::min(start + perPacket, encoder.paletteSize); ++i)
+		{
+			packet.insert(packet.end(), encoder.palette[i], encoder.palette[i] + 3);
+		}
+		packets.push_back(packet);
+	}
+	return packets;
+}
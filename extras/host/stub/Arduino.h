@@ -0,0 +1,89 @@
+#pragma once
+
+// Host stand-in for the Arduino core, just enough to build GizmoLED on Linux
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <string>
+
+typedef uint8_t byte;
+
+#define PROGMEM
+#define PI 3.1415926535897932384626433832795
+
+// Time is simulated, it only moves through delay() and the Host clock functions
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+template<class T, class U>
+auto min(T a, U b) -> decltype(a + b)
+{
+	return a < b ? a : b;
+}
+
+template<class T, class U>
+auto max(T a, U b) -> decltype(a + b)
+{
+	return a > b ? a : b;
+}
+
+class String
+{
+public:
+	String(const char *text = "");
+	String(const std::string &text);
+	String(char c);
+	String(unsigned char value, unsigned char base = 10);
+	String(int value, unsigned char base = 10);
+	String(unsigned int value, unsigned char base = 10);
+	String(long value, unsigned char base = 10);
+	String(unsigned long value, unsigned char base = 10);
+	explicit String(float value, unsigned char decimals = 2);
+	explicit String(double value, unsigned char decimals = 2);
+
+	String operator+(const String &other) const;
+	String &operator+=(const String &other);
+	bool operator==(const char *other) const;
+
+	unsigned int length() const;
+	const char *c_str() const;
+
+private:
+	std::string text;
+};
+
+String operator+(const char *a, const String &b);
+
+class HardwareSerial
+{
+public:
+	void begin(unsigned long baud);
+	void setTimeout(unsigned long timeout);
+
+	void print(const String &text);
+	void print(const char *text);
+	void print(long value, int base = 10);
+	void println(const String &text);
+	void println(const char *text);
+	void println(long value, int base = 10);
+	void println();
+
+	// Output is dropped unless echo is set, the last line is kept for tests
+	bool echo = false;
+	char lastLine[256] = {};
+
+private:
+	std::string line;
+};
+
+extern HardwareSerial Serial;
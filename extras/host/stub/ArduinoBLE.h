@@ -0,0 +1,155 @@
+#pragma once
+
+// Host stand-in for ArduinoBLE. Calls are recorded in the objects so tests can
+// inspect them, and the Host functions at the end play the role of a central.
+
+#include <Arduino.h>
+
+#define HOST_BLE_MAX_VALUE 512
+#define HOST_BLE_MAX_HANDLERS 4
+#define HOST_BLE_MAX_REPORTS 16
+#define HOST_BLE_MAX_ADVERTISEMENT 31
+
+enum BLEProperty
+{
+	BLEBroadcast = 0x01,
+	BLERead = 0x02,
+	BLEWriteWithoutResponse = 0x04,
+	BLEWrite = 0x08,
+	BLENotify = 0x10,
+	BLEIndicate = 0x20,
+};
+
+enum BLEDeviceEvent
+{
+	BLEConnected = 0,
+	BLEDisconnected,
+	BLEDiscovered,
+	BLEDeviceLastEvent,
+};
+
+enum BLECharacteristicEvent
+{
+	BLESubscribed = 0,
+	BLEUnsubscribed = 1,
+	BLEWritten = 3,
+	BLECharacteristicEventLast,
+};
+
+class BLEDevice
+{
+public:
+	BLEDevice(int report = -1) : report(report) {}
+
+	operator bool() const;
+	bool connected() const;
+	String address() const;
+	int rssi();
+
+	bool hasManufacturerData() const;
+	int manufacturerDataLength() const;
+	int manufacturerData(uint8_t *value, int length) const;
+
+	int report;
+};
+
+class BLECharacteristic;
+typedef void (*BLECharacteristicEventHandler)(BLEDevice device, BLECharacteristic characteristic);
+typedef void (*BLEDeviceEventHandler)(BLEDevice device);
+
+struct HostCharacteristic
+{
+	const char *uuid;
+	uint8_t properties;
+	int valueSize;
+	uint8_t value[HOST_BLE_MAX_VALUE];
+	int valueLength;
+	bool subscribed;
+	BLECharacteristicEventHandler handlers[HOST_BLE_MAX_HANDLERS];
+
+	uint32_t writes; // writeValue() calls from the peripheral, i.e. notifications
+};
+
+// Copies share the same characteristic like the ArduinoBLE handle classes
+class BLECharacteristic
+{
+public:
+	BLECharacteristic(const char *uuid, uint8_t properties, int valueSize, bool fixedLength = false);
+
+	const char *uuid() const;
+	int valueSize() const;
+	int valueLength() const;
+	const uint8_t *value() const;
+	int writeValue(const uint8_t *value, int length, bool withResponse = true);
+	bool subscribed();
+	void setEventHandler(int event, BLECharacteristicEventHandler handler);
+
+	HostCharacteristic *local;
+};
+
+class BLEService
+{
+public:
+	BLEService(const char *uuid);
+
+	const char *uuid() const;
+	void addCharacteristic(BLECharacteristic &characteristic);
+
+private:
+	const char *serviceUuid;
+};
+
+class BLELocalDevice
+{
+public:
+	int begin();
+	void end();
+	void poll(unsigned long timeout = 0);
+
+	void setLocalName(const char *name);
+	void setAdvertisedService(const BLEService &service);
+	bool setManufacturerData(const uint8_t data[], int length);
+	bool setManufacturerData(uint16_t companyId, const uint8_t data[], int length);
+	void setAdvertisingInterval(uint16_t interval);
+	void setConnectionInterval(uint16_t minInterval, uint16_t maxInterval);
+	void setSupervisionTimeout(uint16_t timeout);
+
+	int advertise();
+	void stopAdvertise();
+	int scan(bool withDuplicates = false);
+	void stopScan();
+	BLEDevice available();
+
+	BLEDevice central();
+	bool connected() const;
+	bool disconnect();
+	void addService(BLEService &service);
+	void setEventHandler(int event, BLEDeviceEventHandler handler);
+
+	// Recorded state
+	const char *localName = nullptr;
+	const char *advertisedService = nullptr;
+	const uint8_t *manufacturerData = nullptr; // Kept by pointer like ArduinoBLE does
+	int manufacturerDataLength = 0;
+	uint16_t advertisingInterval = 160;
+	uint16_t minConnectionInterval = 0;
+	uint16_t maxConnectionInterval = 0;
+	uint16_t supervisionTimeout = 0;
+	bool advertising = false;
+	bool scanning = false;
+	bool isConnected = false;
+	uint32_t advertiseCalls = 0;
+	uint8_t advertisement[HOST_BLE_MAX_ADVERTISEMENT]; // Snapshot taken by advertise()
+	int advertisementLength = 0;
+	BLEDeviceEventHandler handlers[BLEDeviceLastEvent] = {};
+};
+
+extern BLELocalDevice BLE;
+
+// Host side of the link
+extern void HostWrite(BLECharacteristic &characteristic, const uint8_t *value, int length);
+extern void HostSubscribe(BLECharacteristic &characteristic, bool subscribed);
+extern void HostConnect(bool connected);
+
+// Queues an advertisement with manufacturer data for BLE.available()
+extern void HostDiscover(const uint8_t *manufacturerData, int length);
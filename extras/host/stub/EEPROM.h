@@ -0,0 +1,33 @@
+#pragma once
+
+#include <Arduino.h>
+
+#define HOST_EEPROM_SIZE 4096
+
+class EEPROMClass
+{
+public:
+	void begin(size_t size) { (void)size; }
+	void end() {}
+
+	uint8_t read(int address) { return data[address]; }
+	void write(int address, uint8_t value) { data[address] = value; }
+
+	template<typename T>
+	T &get(int address, T &value)
+	{
+		memcpy(&value, data + address, sizeof(T));
+		return value;
+	}
+
+	template<typename T>
+	const T &put(int address, const T &value)
+	{
+		memcpy(data + address, &value, sizeof(T));
+		return value;
+	}
+
+	uint8_t data[HOST_EEPROM_SIZE] = {};
+};
+
+extern EEPROMClass EEPROM;
@@ -0,0 +1,17 @@
+#pragma once
+
+// Host stand-in for the ArduinoBLE ATT layer, only the connection lookup is used
+
+#include <Arduino.h>
+
+#define HOST_CONNECTION_HANDLE 0x0040
+#define HOST_CENTRAL_ADDRESS_TYPE 1 // Random, like most phones
+
+class ATTClass
+{
+public:
+	// 0xFFFF when no central with that address is connected
+	uint16_t connectionHandle(uint8_t addressType, const uint8_t address[6]) const;
+};
+
+extern ATTClass ATT;
@@ -0,0 +1,22 @@
+#pragma once
+
+// Host stand-in for the ArduinoBLE HCI layer, ACL packets are recorded
+
+#include <Arduino.h>
+
+#define HOST_HCI_MAX_PACKET 64
+
+class HCIClass
+{
+public:
+	int sendAclPkt(uint16_t handle, uint8_t cid, uint8_t plen, void *data);
+
+	// Recorded state
+	uint32_t aclPackets = 0;
+	uint16_t lastAclHandle = 0;
+	uint8_t lastAclCid = 0;
+	uint8_t lastAcl[HOST_HCI_MAX_PACKET];
+	int lastAclLength = 0;
+};
+
+extern HCIClass HCI;
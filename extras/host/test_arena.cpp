@@ -0,0 +1,66 @@
+#include <ArduinoBLE.h>
+#include <arena.h>
+#include <ledlayout.h>
+
+#include "harness.h"
+
+using namespace GizmoLED;
+
+void TestScratch()
+{
+	const size_t mark = ArenaMark();
+	uint8_t *a = ArenaAllocArray<uint8_t>(3);
+	uint32_t *b = ArenaAllocArray<uint32_t>(4);
+	CHECK(a != nullptr && b != nullptr);
+	CHECK_EQUAL(0u, uintptr_t(b) % alignof(uint32_t));
+	CHECK(GetArenaUsed() >= mark + 3 + 16);
+	ArenaRelease(mark);
+	CHECK_EQUAL(mark, GetArenaUsed());
+	CHECK(GetArenaPeak() >= mark + 3 + 16);
+	CHECK(!IsArenaExhausted());
+}
+
+void TestLayoutFallback()
+{
+	// Room for the layout arrays of 100 LEDs, not for the float scratch used to bake them
+	const size_t mark = ArenaMark();
+	const size_t layoutBytes = 100 * 7 + 4 * ARENA_DEFAULT_ALIGN;
+	CHECK(ArenaAlloc(GetArenaSize() - GetArenaUsed() - layoutBytes - ARENA_DEFAULT_ALIGN) != nullptr);
+	const size_t full = GetArenaUsed();
+
+	Layout layout;
+	LayoutRing(layout, 100);
+	CHECK_EQUAL(0, layout.numLeds);
+	CHECK_EQUAL(full, GetArenaUsed());
+	CHECK(GetLayoutProjection(layout, 64) == nullptr || layout.numLeds == 0);
+	CHECK(IsArenaExhausted());
+
+	// Not even the layout arrays fit
+	const float xy[] = { 0.0f, 0.0f, 1.0f, 1.0f };
+	LayoutStrip(layout, 1000);
+	CHECK_EQUAL(0, layout.numLeds);
+	LayoutPoints(layout, xy, 1000);
+	CHECK_EQUAL(0, layout.numLeds);
+	CHECK_EQUAL(full, GetArenaUsed());
+
+	// Small layouts still fit in what is left
+	LayoutPoints(layout, xy, 2);
+	CHECK_EQUAL(2, layout.numLeds);
+	ArenaRelease(mark);
+}
+
+void TestExhausted()
+{
+	const size_t used = GetArenaUsed();
+	CHECK(ArenaAlloc(GetArenaSize() + 1) == nullptr);
+	CHECK_EQUAL(used, GetArenaUsed());
+	CHECK(IsArenaExhausted());
+}
+
+int main()
+{
+	TestScratch();
+	TestLayoutFallback();
+	TestExhausted();
+	return HostTestResult("arena");
+}
@@ -0,0 +1,107 @@
+#include <ArduinoBLE.h>
+#include <clocksync.h>
+#include <linkpolicy.h>
+
+#include "harness.h"
+
+using namespace GizmoLED;
+
+BLEService ledService("e8942ca1-d9e7-4c45-b96c-30cf850bfa00");
+
+void TestBeaconRoundTrip()
+{
+	uint8_t beacon[SYNC_BEACON_SIZE];
+	CHECK_EQUAL(SYNC_BEACON_SIZE, ClockSyncWriteBeacon(beacon, 0x13, 0x89ABCDEF, 7));
+
+	uint8_t sequence, effectName;
+	uint32_t phase;
+	CHECK(ClockSyncReadBeacon(beacon, SYNC_BEACON_SIZE, &sequence, &phase, &effectName));
+	CHECK_EQUAL(0x3, sequence);
+	CHECK_EQUAL(0x89ABCDEFu, phase);
+	CHECK_EQUAL(7, effectName);
+
+	CHECK(!ClockSyncReadBeacon(beacon, SYNC_BEACON_SIZE - 1, &sequence, &phase, &effectName));
+	beacon[2] ^= 0x50;
+	CHECK(!ClockSyncReadBeacon(beacon, SYNC_BEACON_SIZE, &sequence, &phase, &effectName));
+}
+
+void TestLostBeaconsWrap()
+{
+	ClockSync sync;
+	ClockSyncReset(sync);
+
+	// Sequences wrap at 16, every third beacon is missed
+	uint32_t phase = 0;
+	int sent = 0;
+	for (uint8_t sequence = 0; sent < 60; ++sequence, ++sent)
+	{
+		phase += 6554;
+		if (sent % 3 != 2)
+		{
+			ClockSyncSample(sync, phase, sequence, phase);
+			ClockSyncSample(sync, phase, sequence, phase + 100); // Rebroadcast copy
+		}
+	}
+	CHECK_EQUAL(40u, sync.samples);
+	CHECK_EQUAL(19u, sync.lost);
+	CHECK(sync.locked);
+}
+
+// Overwrites the stack the beacon used to live on
+void ClobberStack()
+{
+	uint8_t scratch[256];
+	memset(scratch, 0xEE, sizeof scratch);
+	BenchUse(scratch);
+}
+
+void TestBeaconAdvertised()
+{
+	BLE.setAdvertisedService(ledService);
+	BLE.advertise();
+	CHECK_EQUAL(3 + 18, BLE.advertisementLength);
+
+	SetSyncRole(SYNCROLE_MASTER);
+	HostAdvanceMicros(SYNC_BEACON_INTERVAL * 1000);
+	UpdateClockSync(0x12345678, 9);
+	CHECK_EQUAL(SYNC_ADVERTISING_INTERVAL, BLE.advertisingInterval);
+
+	// The full beacon made it into the packet next to the 128-bit UUID
+	CHECK_EQUAL(3 + 18 + 2 + SYNC_BEACON_SIZE, BLE.advertisementLength);
+	CHECK(BLE.advertisementLength <= 31);
+	uint8_t sequence, effectName;
+	uint32_t phase;
+	CHECK(ClockSyncReadBeacon(BLE.advertisement + 3 + 18 + 2, SYNC_BEACON_SIZE, &sequence, &phase, &effectName));
+	CHECK_EQUAL(0x12345678u, phase);
+	CHECK_EQUAL(9, effectName);
+
+	// ArduinoBLE advertises from the pointer it was given
+	ClobberStack();
+	CHECK(ClockSyncReadBeacon(BLE.manufacturerData, BLE.manufacturerDataLength, &sequence, &phase, &effectName));
+	CHECK_EQUAL(0x12345678u, phase);
+}
+
+void TestLinkPolicyKeepsSyncInterval()
+{
+	BeginLinkPolicy(EFFECTTYPE_DEFAULT);
+	CHECK(UpdateLinkPolicy(EFFECTTYPE_STREAM, true));
+	CHECK_EQUAL(SYNC_ADVERTISING_INTERVAL, BLE.advertisingInterval);
+
+	// Leaving the master role restores the policy interval and drops the beacon
+	SetSyncRole(SYNCROLE_NONE);
+	CHECK_EQUAL(GetLinkPolicy().advertisingInterval, BLE.advertisingInterval);
+	CHECK(BLE.advertising);
+	CHECK_EQUAL(3 + 18, BLE.advertisementLength);
+
+	CHECK(UpdateLinkPolicy(EFFECTTYPE_DEFAULT, true));
+	CHECK_EQUAL(linkPolicies[LINKPOLICY_INTERACTIVE].advertisingInterval, BLE.advertisingInterval);
+}
+
+int main()
+{
+	TestBeaconRoundTrip();
+	TestLostBeaconsWrap();
+	TestBeaconAdvertised();
+	TestLinkPolicyKeepsSyncInterval();
+	return HostTestResult("clocksync");
+}
@@ -0,0 +1,89 @@
+#include <ArduinoBLE.h>
+#include <colorpalette.h>
+
+#include "harness.h"
+
+using namespace GizmoLED;
+
+uint8_t rainbowSettings[] = {
+	VARTYPE_CHECKBOX, VARNAME_RAINBOWENABLED, 1,
+	VARTYPE_SLIDER, VARNAME_RAINBOWLENGTH, 100, 0, 100,
+	VARTYPE_SLIDER, VARNAME_RAINBOWOFFSET, 0, 0, 100,
+};
+
+uint8_t gradientSettings[] = {
+	VARTYPE_COLOR, VARNAME_COLOR1, 200, 0, 0,
+	VARTYPE_COLOR, VARNAME_COLOR2, 0, 100, 0,
+	VARTYPE_SLIDER, VARNAME_NUMBEROFCOLORS, 2, 1, 3,
+};
+
+void TestRainbowMatchesHSV()
+{
+	Effect effect = {};
+	effect.settings = rainbowSettings;
+	effect.settingsSize = sizeof rainbowSettings;
+
+	Palette palette;
+	BakePalette(palette, effect);
+	CHECK(!palette.dirty);
+
+	int maxError = 0;
+	for (int i = 0; i < PALETTE_SIZE; ++i)
+	{
+		uint8_t rgb[3];
+		HSV2RGB(i * 360.0f / PALETTE_SIZE, 100.0f, 100.0f, rgb);
+		for (int c = 0; c < 3; ++c)
+		{
+			maxError = MAX(maxError, abs(rgb[c] - PaletteSample(palette, i)[c]));
+		}
+	}
+	CHECK_EQUAL(0, maxError);
+}
+
+void TestGradientWraps()
+{
+	Effect effect = {};
+	effect.settings = gradientSettings;
+	effect.settingsSize = sizeof gradientSettings;
+
+	Palette palette;
+	BakePalette(palette, effect);
+
+	// Color1 at the start, color2 half way, back towards color1 at the end
+	CHECK_EQUAL(200, PaletteSample(palette, 0)[0]);
+	CHECK_EQUAL(0, PaletteSample(palette, 128)[0]);
+	CHECK_EQUAL(100, PaletteSample(palette, 128)[1]);
+	CHECK(PaletteSample(palette, 255)[0] > 190);
+
+	uint8_t rgb[3];
+	PaletteSampleOffset(palette, 64 << 8, rgb);
+	CHECK_EQUAL(PaletteSample(palette, 64)[0], rgb[0]);
+}
+
+void TestRegisterOverflow()
+{
+	static Palette palettes[MAX_PALETTES + 1];
+	for (int i = 0; i < MAX_PALETTES; ++i)
+	{
+		CHECK(RegisterPalette(palettes[i], EFFECTNAME_GRADIENT));
+	}
+
+	Serial.lastLine[0] = 0;
+	CHECK(!RegisterPalette(palettes[MAX_PALETTES], EFFECTNAME_GRADIENT));
+	CHECK(strstr(Serial.lastLine, "MAX_PALETTES") != nullptr);
+
+	for (int i = 0; i < MAX_PALETTES; ++i)
+	{
+		palettes[i].dirty = false;
+	}
+	InvalidatePalettes(EFFECTNAME_GRADIENT);
+	CHECK(palettes[0].dirty && palettes[MAX_PALETTES - 1].dirty);
+}
+
+int main()
+{
+	TestRainbowMatchesHSV();
+	TestGradientWraps();
+	TestRegisterOverflow();
+	return HostTestResult("colorpalette");
+}
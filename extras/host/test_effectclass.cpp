@@ -0,0 +1,161 @@
+#include <ArduinoBLE.h>
+#include <gizmoled.h>
+#include <effectclass.h>
+
+#include "harness.h"
+
+// Host sketch with two effect classes and an animation function sharing one arena
+
+using namespace GizmoLED;
+
+#define NUM_LEDS 16
+
+extern BLECharacteristic effectTypeCharacteristic;
+
+uint8_t frame[NUM_LEDS * 3];
+int begins = 0;
+int ends = 0;
+int functionRenders = 0;
+
+BEGIN_EFFECT_SETTINGS(fade, EFFECTNAME_OPAQUE,
+	DECLARE_EFFECT_SETTINGS_COLOR(GizmoLED::VARNAME_COLOR, 20, 40, 60)
+)
+EFFECT_VAR_COLOR(color)
+END_EFFECT_SETTINGS()
+
+BEGIN_EFFECT_SETTINGS(wave, EFFECTNAME_WAVES,
+	DECLARE_EFFECT_SETTINGS_SLIDER(GizmoLED::VARNAME_SPEED, 50, 0, 100)
+)
+EFFECT_VAR_SLIDER(speed)
+END_EFFECT_SETTINGS()
+
+BEGIN_EFFECT_SETTINGS(blink, EFFECTNAME_BLINK,
+	DECLARE_EFFECT_SETTINGS_SLIDER(GizmoLED::VARNAME_SPEED, 50, 0, 100)
+)
+EFFECT_VAR_SLIDER(speed)
+END_EFFECT_SETTINGS()
+
+class Fade : public GizmoLED::EffectClass<Fade>
+{
+public:
+	void begin()
+	{
+		++begins;
+		base = color(GizmoLED::VARNAME_COLOR);
+	}
+
+	void render(float frameTime)
+	{
+		lastFrameTime = frameTime;
+		++renders;
+		for (int i = 0; i < NUM_LEDS; ++i)
+		{
+			memcpy(frame + i * 3, base.rgb(), 3);
+		}
+	}
+
+	void end() { ++ends; }
+
+	static float lastFrameTime;
+	static int renders;
+
+private:
+	GizmoLED::ColorVar base;
+	uint8_t padding[40];
+};
+
+float Fade::lastFrameTime = 0.0f;
+int Fade::renders = 0;
+
+class Wave : public GizmoLED::EffectClass<Wave>
+{
+public:
+	static constexpr uint8_t targetFps = 30;
+
+	void begin() { ++begins; }
+
+	void render(const GizmoLED::FixedFrameTime &time)
+	{
+		lastPhase = time.phase;
+		++renders;
+		memset(frame, uint8_t(time.phase >> 8), sizeof frame);
+	}
+
+	~Wave() { ++destroyed; }
+
+	static uint32_t lastPhase;
+	static int renders;
+	static int destroyed;
+};
+
+uint32_t Wave::lastPhase = 0;
+int Wave::renders = 0;
+int Wave::destroyed = 0;
+
+void BlinkAnimation(float frameTime)
+{
+	++functionRenders;
+}
+
+GIZMOLED_EFFECT_ARENA(Fade, Wave);
+
+BEGIN_EFFECTS()
+DECLARE_EFFECT_CLASS(fade, Fade, GizmoLED::EFFECTTYPE_DEFAULT)
+DECLARE_EFFECT_CLASS(wave, Wave, GizmoLED::EFFECTTYPE_DEFAULT)
+DECLARE_EFFECT(blink, BlinkAnimation, GizmoLED::EFFECTTYPE_DEFAULT)
+END_EFFECTS()
+
+static_assert(HasFixedRender<Wave>::value && !HasFixedRender<Fade>::value, "Render path detection");
+static_assert(GizmoLEDEffectArena::size >= sizeof(Fade) && GizmoLEDEffectArena::size >= sizeof(Wave), "Arena size");
+
+void SelectEffect(uint8_t index)
+{
+	HostWrite(effectTypeCharacteristic, &index, 1);
+}
+
+void TestTable()
+{
+	CHECK_EQUAL(1, _effects[0].effectClass);
+	CHECK_EQUAL(2, _effects[1].effectClass);
+	CHECK_EQUAL(0, _effects[2].effectClass);
+	CHECK(_effects[0].fnEffectAnimation == nullptr);
+	CHECK_EQUAL(30, _effects[1].targetFps);
+}
+
+void TestDispatch()
+{
+	SelectEffect(0);
+	GIZMOLED_LOOP();
+	GIZMOLED_LOOP();
+	CHECK_EQUAL(1, begins);
+	CHECK(Fade::renders >= 2);
+	CHECK(Fade::lastFrameTime > 0.0f);
+	CHECK_EQUAL(20, frame[0]);
+	CHECK_EQUAL(60, frame[NUM_LEDS * 3 - 1]);
+
+	// Switching ends the old class and constructs the new one in the same storage
+	SelectEffect(1);
+	GIZMOLED_LOOP();
+	const uint32_t phase = Wave::lastPhase;
+	GIZMOLED_LOOP();
+	CHECK_EQUAL(1, ends);
+	CHECK_EQUAL(2, begins);
+	CHECK_EQUAL(2, Wave::renders);
+	CHECK(Wave::lastPhase > phase);
+
+	SelectEffect(2);
+	GIZMOLED_LOOP();
+	CHECK_EQUAL(1, Wave::destroyed);
+	CHECK_EQUAL(1, functionRenders);
+	CHECK_EQUAL(2, begins);
+}
+
+int main()
+{
+	SetFrameBuffer(frame, NUM_LEDS);
+	GIZMOLED_SETUP();
+
+	TestTable();
+	TestDispatch();
+	return HostTestResult("effectclass");
+}
@@ -0,0 +1,94 @@
+#include <ArduinoBLE.h>
+#include <fixedmath.h>
+
+#include "harness.h"
+
+using namespace GizmoLED;
+
+void TestSin()
+{
+	int maxError = 0;
+	for (int angle = 0; angle < 65536; angle += 7)
+	{
+		const int expected = int(round(sin(angle * 2.0 * PI / 65536.0) * 32767.0));
+		maxError = max(maxError, abs(Sin16(angle) - expected));
+	}
+	CHECK(maxError <= 40);
+
+	CHECK_EQUAL(0, Sin16(0));
+	CHECK_EQUAL(32767, Sin16(0x4000));
+	CHECK_EQUAL(-32767, Sin16(0xC000));
+	CHECK_EQUAL(32767, Cos16(0));
+	CHECK_EQUAL(128, Sin8(0));
+	CHECK_EQUAL(255, Sin8(64));
+	CHECK_EQUAL(0, Cos8(128));
+}
+
+void TestScaleLerp()
+{
+	CHECK_EQUAL(255, Scale8(255, 255));
+	CHECK_EQUAL(0, Scale8(255, 0));
+	CHECK_EQUAL(128, Scale8(255, 128));
+	CHECK_EQUAL(65535, Scale16(65535, 65535));
+
+	CHECK_EQUAL(10, Lerp8(10, 200, 0));
+	CHECK_EQUAL(105, Lerp8(10, 200, 128));
+	CHECK_EQUAL(200, Lerp8(200, 10, 0));
+	CHECK_EQUAL(1000, Lerp16(1000, 3000, 0));
+	CHECK_EQUAL(2000, Lerp16(1000, 3000, 32768));
+	CHECK_EQUAL(39999, Lerp16(0, 65535, 40000));
+	CHECK_EQUAL(25536, Lerp16(65535, 0, 40000));
+	CHECK_EQUAL(65534, Lerp16(0, 65535, 65535));
+	CHECK_EQUAL(1, Lerp16(65535, 0, 65535));
+	CHECK_EQUAL(65535, Lerp16(65535, 65535, 65535));
+
+	int errors16 = 0;
+	for (int fraction = 0; fraction < 65536; fraction += 97)
+	{
+		const double up = 65535.0 * fraction / 65536.0;
+		errors16 += fabs(Lerp16(0, 65535, fraction) - up) > 1.0;
+		errors16 += fabs(Lerp16(65535, 0, fraction) - (65535.0 - up)) > 1.0;
+	}
+	CHECK_EQUAL(0, errors16);
+
+	int errors = 0;
+	for (int t = 0; t < 256; ++t)
+	{
+		const double expected = 10 + (200 - 10) * t / 256.0;
+		errors += abs(Lerp8(10, 200, t) - expected) > 1.0;
+	}
+	CHECK_EQUAL(0, errors);
+}
+
+void TestEasing()
+{
+	CHECK_EQUAL(0, Ease8InOutCubic(0));
+	CHECK_EQUAL(255, Ease8InOutCubic(255));
+	CHECK_EQUAL(0, Ease8InOutQuad(0));
+	CHECK(Ease8InOutQuad(255) >= 254);
+
+	int decreases = 0;
+	for (int t = 1; t < 256; ++t)
+	{
+		decreases += Ease8InOutCubic(t) < Ease8InOutCubic(t - 1);
+		decreases += Ease8InQuad(t) < Ease8InQuad(t - 1);
+	}
+	CHECK_EQUAL(0, decreases);
+}
+
+void TestPhase()
+{
+	// 1 Hz over half a second is half a cycle, 2 Hz wraps once
+	const FixedFrameTime time = { 500000, 0, 32768 };
+	CHECK_EQUAL(32768, GetPhase16(time, 65536));
+	CHECK_EQUAL(0, GetPhase16(time, 131072));
+}
+
+int main()
+{
+	TestSin();
+	TestScaleLerp();
+	TestEasing();
+	TestPhase();
+	return HostTestResult("fixedmath");
+}
@@ -0,0 +1,109 @@
+#include <ArduinoBLE.h>
+#include <framestream.h>
+
+#include "harness.h"
+#include "streamencoder.h"
+#include "testanimations.h"
+
+using namespace GizmoLED;
+
+#define NUM_LEDS 150
+
+StreamDecoder decoder;
+uint8_t source[NUM_LEDS * 3];
+uint8_t frame[NUM_LEDS * 3];
+
+// Returns the number of completed frames
+int Decode(const std::vector<std::vector<uint8_t>> &packets)
+{
+	int completed = 0;
+	for (const std::vector<uint8_t> &packet : packets)
+	{
+		completed += StreamDecodePacket(decoder, packet.data(), packet.size(), frame, NUM_LEDS);
+	}
+	return completed;
+}
+
+void TestRoundTrip(int maxPacket, bool usePalette)
+{
+	for (int animation = 0; animation < NUM_TESTANIMATIONS; ++animation)
+	{
+		StreamEncoder encoder;
+		if (usePalette)
+		{
+			encoder.palette = GetTestRainbowPalette();
+			encoder.paletteSize = 256;
+		}
+
+		StreamReset(decoder);
+		memset(frame, 0, sizeof frame);
+		Decode(StreamEncodePalette(encoder));
+
+		int mismatches = 0;
+		for (int f = 0; f < 100; ++f)
+		{
+			RenderTestAnimation(animation, f, source, NUM_LEDS);
+			const bool keyframe = f % 30 == 0;
+			CHECK_EQUAL(1, Decode(StreamEncodeFrame(encoder, source, NUM_LEDS, keyframe, maxPacket)));
+			mismatches += memcmp(source, frame, sizeof frame) != 0;
+		}
+		CHECK_EQUAL(0, mismatches);
+		CHECK_EQUAL(0, decoder.packetsDropped);
+	}
+}
+
+void TestPacketLoss()
+{
+	StreamEncoder encoder;
+	StreamReset(decoder);
+
+	RenderTestAnimation(TESTANIMATION_METEOR, 0, source, NUM_LEDS);
+	CHECK_EQUAL(1, Decode(StreamEncodeFrame(encoder, source, NUM_LEDS, true, 16)));
+
+	// A lost packet drops the rest of the frame and all deltas until the next keyframe
+	RenderTestAnimation(TESTANIMATION_RAINBOW, 1, source, NUM_LEDS);
+	std::vector<std::vector<uint8_t>> packets = StreamEncodeFrame(encoder, source, NUM_LEDS, false, 16);
+	packets.erase(packets.begin() + 1);
+	CHECK_EQUAL(0, Decode(packets));
+	CHECK_EQUAL(1, decoder.packetsDropped);
+	CHECK(!decoder.synced);
+
+	RenderTestAnimation(TESTANIMATION_RAINBOW, 2, source, NUM_LEDS);
+	CHECK_EQUAL(0, Decode(StreamEncodeFrame(encoder, source, NUM_LEDS, false, 16)));
+
+	RenderTestAnimation(TESTANIMATION_RAINBOW, 3, source, NUM_LEDS);
+	CHECK_EQUAL(1, Decode(StreamEncodeFrame(encoder, source, NUM_LEDS, true, 16)));
+	CHECK(memcmp(source, frame, sizeof frame) == 0);
+}
+
+void TestShortFrameBuffer()
+{
+	// Pixels past the frame buffer are dropped, nothing is written out of bounds
+	StreamEncoder encoder;
+	StreamReset(decoder);
+
+	uint8_t small[10 * 3 + 3];
+	memset(small, 0xEE, sizeof small);
+	RenderTestAnimation(TESTANIMATION_RAINBOW, 0, source, NUM_LEDS);
+	const std::vector<std::vector<uint8_t>> packets = StreamEncodeFrame(encoder, source, NUM_LEDS, true);
+	for (const std::vector<uint8_t> &packet : packets)
+	{
+		StreamDecodePacket(decoder, packet.data(), packet.size(), small, 10);
+	}
+	CHECK(memcmp(small, source, 10 * 3) == 0);
+	CHECK_EQUAL(0xEE, small[30]);
+}
+
+int main()
+{
+	TestRoundTrip(STREAM_MAX_PACKET, false);
+	TestRoundTrip(STREAM_MAX_PACKET, true);
+
+	// One op byte per packet, every op and pixel is split between packets
+	TestRoundTrip(3, false);
+	TestRoundTrip(3, true);
+
+	TestPacketLoss();
+	TestShortFrameBuffer();
+	return HostTestResult("framestream");
+}
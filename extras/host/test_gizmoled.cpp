@@ -0,0 +1,185 @@
+#include <ArduinoBLE.h>
+#include <gizmoled.h>
+#include <ledoutput.h>
+#include <ledlayout.h>
+#include <arena.h>
+
+#include "harness.h"
+
+// Host sketch with one static and one animated effect, driven through the loop
+
+using namespace GizmoLED;
+
+#define NUM_LEDS 30
+
+extern BLECharacteristic effectTypeCharacteristic;
+extern BLECharacteristic previewCharacteristic;
+
+uint8_t frame[NUM_LEDS * 3];
+uint8_t output[NUM_LEDS * 3];
+int opaqueRenders = 0;
+int blinkRenders = 0;
+
+BEGIN_EFFECT_SETTINGS(opaque, EFFECTNAME_OPAQUE,
+	DECLARE_EFFECT_SETTINGS_COLOR(GizmoLED::VARNAME_COLOR, 20, 2, 1)
+)
+EFFECT_VAR_COLOR(color)
+END_EFFECT_SETTINGS()
+
+BEGIN_EFFECT_SETTINGS(blink, EFFECTNAME_BLINK,
+	DECLARE_EFFECT_SETTINGS_SLIDER(GizmoLED::VARNAME_SPEED, 50, 0, 100)
+)
+EFFECT_VAR_SLIDER(speed)
+END_EFFECT_SETTINGS()
+
+void OpaqueAnimation(float frameTime)
+{
+	++opaqueRenders;
+	for (int i = 0; i < NUM_LEDS; ++i)
+	{
+		memcpy(frame + i * 3, opaqueSettings::color, 3);
+	}
+}
+
+void BlinkAnimation(float frameTime)
+{
+	++blinkRenders;
+	memset(frame, (blinkRenders & 1) ? 255 : 0, sizeof frame);
+}
+
+BEGIN_EFFECTS()
+DECLARE_STATIC_EFFECT(opaque, OpaqueAnimation, GizmoLED::EFFECTTYPE_DEFAULT)
+DECLARE_EFFECT(blink, BlinkAnimation, GizmoLED::EFFECTTYPE_DEFAULT)
+END_EFFECTS()
+
+void SelectEffect(uint8_t index)
+{
+	HostWrite(effectTypeCharacteristic, &index, 1);
+}
+
+// Time spent in one loop iteration
+uint64_t Loop()
+{
+	const uint64_t start = HostMicros();
+	GIZMOLED_LOOP();
+	return HostMicros() - start;
+}
+
+void TestStaticFramesIdle()
+{
+	SelectEffect(0);
+	for (int i = 0; i < 5; ++i)
+	{
+		Loop();
+	}
+
+	// Rendered once, then the loop sleeps in BLE.poll
+	const int renders = opaqueRenders;
+	CHECK(Loop() >= 100000);
+	CHECK_EQUAL(renders, opaqueRenders);
+	CHECK(GetEffectStats(_effects[0]).framesSkipped > 0);
+
+	SelectEffect(1);
+	Loop();
+	const int blinks = blinkRenders;
+	const uint64_t elapsed = Loop();
+	CHECK(elapsed > 16000 && elapsed < 17000);
+	CHECK_EQUAL(blinks + 1, blinkRenders);
+}
+
+void TestDitheringKeepsOutputRefreshing()
+{
+	SelectEffect(0);
+	Loop();
+	Loop();
+	const int renders = opaqueRenders;
+
+	// Using the output stage alone keeps the idle sleep
+	SetOutputBrightness(40);
+	ApplyOutput(frame, output, sizeof frame);
+	CHECK(!IsOutputDitheringActive());
+	CHECK(Loop() >= 100000);
+
+	// Dim static colors only hold their level through dithering over several frames
+	SetOutputDithering(true);
+	CHECK(IsOutputDitheringActive());
+
+	int outputSum = 0;
+	for (int i = 0; i < 8; ++i)
+	{
+		const uint64_t elapsed = Loop();
+		CHECK(elapsed > 16000 && elapsed < 17000);
+		ApplyOutput(frame, output, sizeof frame);
+		outputSum += output[0];
+	}
+	CHECK_EQUAL(renders, opaqueRenders);
+	CHECK(outputSum > 0);
+
+	SetOutputDithering(false);
+	CHECK(Loop() >= 100000);
+}
+
+void SetOpaqueColor(uint8_t r, uint8_t g, uint8_t b)
+{
+	BLECharacteristic &characteristic = *_effects[0].characteristic;
+	uint8_t value[HOST_BLE_MAX_VALUE];
+	memcpy(value, characteristic.value(), characteristic.valueLength());
+
+	const int offset = (uint8_t*)opaqueSettings::color - (uint8_t*)_effects[0].settings;
+	value[offset] = r;
+	value[offset + 1] = g;
+	value[offset + 2] = b;
+	HostWrite(characteristic, value, characteristic.valueLength());
+}
+
+void TestPreviewOnStaticFrames()
+{
+	SelectEffect(0);
+	Loop();
+	Loop();
+	const int renders = opaqueRenders;
+
+	// A new subscriber gets the current frame even though nothing renders
+	const uint32_t writes = previewCharacteristic.local->writes;
+	HostSubscribe(previewCharacteristic, true);
+	CHECK(Loop() >= 100000);
+	CHECK_EQUAL(writes + 1, previewCharacteristic.local->writes);
+	CHECK_EQUAL(renders, opaqueRenders);
+
+	// A change right after a preview goes out once the interval has passed,
+	// the idle sleep is cut short for it
+	SetOpaqueColor(0, 0, 255);
+	uint64_t elapsed = 0;
+	for (int i = 0; i < 4 && previewCharacteristic.local->writes == writes + 1; ++i)
+	{
+		elapsed += Loop();
+	}
+	CHECK_EQUAL(writes + 2, previewCharacteristic.local->writes);
+	CHECK(elapsed <= 1000000UL / 10 * 2 + 17000);
+	CHECK_EQUAL(renders + 1, opaqueRenders);
+
+	// Nothing new to show, no more notifications
+	Loop();
+	Loop();
+	CHECK_EQUAL(writes + 2, previewCharacteristic.local->writes);
+
+	HostSubscribe(previewCharacteristic, false);
+}
+
+int main()
+{
+	SetFrameBuffer(frame, NUM_LEDS);
+
+	// A layout that doesn't fit is left empty, setup still completes
+	Layout layout;
+	LayoutStrip(layout, GIZMOLED_ARENA_SIZE);
+	CHECK_EQUAL(0, layout.numLeds);
+	CHECK(IsArenaExhausted());
+	GIZMOLED_SETUP();
+	CHECK(_effects[0].characteristic != nullptr);
+
+	TestStaticFramesIdle();
+	TestDitheringKeepsOutputRefreshing();
+	TestPreviewOnStaticFrames();
+	return HostTestResult("gizmoled");
+}
@@ -0,0 +1,194 @@
+#include <ArduinoBLE.h>
+#include <gizmoled.h>
+#include <effectclass.h>
+#include <framepreview.h>
+
+#include "harness.h"
+#include "streamencoder.h"
+#include "testanimations.h"
+
+// Host sketch that counts heap allocations once setup is done, everything
+// the loop needs must come from the arena or static storage.
+
+using namespace GizmoLED;
+
+#define NUM_LEDS 60
+
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *pointer, size_t size);
+
+bool countAllocations = false;
+int allocations = 0;
+
+extern "C" void *malloc(size_t size)
+{
+	allocations += countAllocations;
+	return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+	allocations += countAllocations;
+	return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *pointer, size_t size)
+{
+	allocations += countAllocations;
+	return __libc_realloc(pointer, size);
+}
+
+extern BLECharacteristic effectTypeCharacteristic;
+extern BLECharacteristic fnCallCharacteristic;
+extern BLECharacteristic previewCharacteristic;
+extern BLECharacteristic streamCharacteristic;
+extern void StoreCurrentSettings();
+
+uint8_t frame[NUM_LEDS * 3];
+int frameIndex = 0;
+
+BEGIN_EFFECT_SETTINGS(opaque, EFFECTNAME_OPAQUE,
+	DECLARE_EFFECT_SETTINGS_COLOR(GizmoLED::VARNAME_COLOR, 20, 2, 1)
+)
+EFFECT_VAR_COLOR(color)
+END_EFFECT_SETTINGS()
+
+BEGIN_EFFECT_SETTINGS(rainbow, EFFECTNAME_WHEEL,
+	DECLARE_EFFECT_SETTINGS_SLIDER(GizmoLED::VARNAME_SPEED, 50, 0, 100)
+)
+EFFECT_VAR_SLIDER(speed)
+END_EFFECT_SETTINGS()
+
+BEGIN_EFFECT_SETTINGS(meteor, EFFECTNAME_METEOR,
+	DECLARE_EFFECT_SETTINGS_SLIDER(GizmoLED::VARNAME_SPEED, 50, 0, 100)
+)
+EFFECT_VAR_SLIDER(speed)
+END_EFFECT_SETTINGS()
+
+BEGIN_EFFECT_SETTINGS(stream, EFFECTNAME_EMPTY,
+	DECLARE_EFFECT_SETTINGS_CHECKBOX(GizmoLED::VARNAME_RAINBOWENABLED, 1)
+)
+EFFECT_VAR_CHECKBOX(enabled)
+END_EFFECT_SETTINGS()
+
+void OpaqueAnimation(float frameTime)
+{
+	for (int i = 0; i < NUM_LEDS; ++i)
+	{
+		memcpy(frame + i * 3, opaqueSettings::color, 3);
+	}
+}
+
+void RainbowAnimation(const FixedFrameTime &time)
+{
+	RenderTestAnimation(TESTANIMATION_RAINBOW, frameIndex++, frame, NUM_LEDS);
+}
+
+class Meteor : public GizmoLED::EffectClass<Meteor>
+{
+public:
+	void render(float frameTime)
+	{
+		RenderTestAnimation(TESTANIMATION_METEOR, head++, frame, NUM_LEDS);
+	}
+
+private:
+	int head = 0;
+};
+
+void StreamAnimation(float frameTime)
+{
+}
+
+GIZMOLED_EFFECT_ARENA(Meteor);
+
+BEGIN_EFFECTS()
+DECLARE_STATIC_EFFECT(opaque, OpaqueAnimation, GizmoLED::EFFECTTYPE_DEFAULT)
+DECLARE_EFFECT_FIXED(rainbow, RainbowAnimation, GizmoLED::EFFECTTYPE_DEFAULT)
+DECLARE_EFFECT_CLASS(meteor, Meteor, GizmoLED::EFFECTTYPE_DEFAULT)
+DECLARE_EFFECT(stream, StreamAnimation, GizmoLED::EFFECTTYPE_STREAM)
+END_EFFECTS()
+
+void SelectEffect(uint8_t index)
+{
+	HostWrite(effectTypeCharacteristic, &index, 1);
+}
+
+void CallFunction(uint8_t index, uint8_t arg)
+{
+	static uint8_t trigger = 0;
+	const uint8_t call[] = { ++trigger, index, arg };
+	HostWrite(fnCallCharacteristic, call, sizeof call);
+}
+
+void Loops(int count)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		GIZMOLED_LOOP();
+	}
+}
+
+int main()
+{
+	SetFrameBuffer(frame, NUM_LEDS);
+	GIZMOLED_SETUP();
+
+	// Frames for the stream effect are encoded up front, the encoder uses std::vector
+	StreamEncoder encoder;
+	std::vector<std::vector<uint8_t>> packets[8];
+	uint8_t source[NUM_LEDS * 3];
+	for (int f = 0; f < 8; ++f)
+	{
+		RenderTestAnimation(TESTANIMATION_SPARKLE, f, source, NUM_LEDS);
+		packets[f] = StreamEncodeFrame(encoder, source, NUM_LEDS, f == 0);
+	}
+
+	// Connecting reads the central address, which ArduinoBLE only hands out as a String
+	HostConnect(true);
+	Loops(4);
+	countAllocations = true;
+
+	Loops(200);
+	HostSubscribe(previewCharacteristic, true);
+	CallFunction(3, 30);
+
+	for (uint8_t effect = 0; effect < 3; ++effect)
+	{
+		SelectEffect(effect);
+		Loops(100);
+
+		// Settings edits from the app, then the delayed save
+		BLECharacteristic &settings = *_effects[effect].characteristic;
+		uint8_t value[HOST_BLE_MAX_VALUE];
+		memcpy(value, settings.value(), settings.valueLength());
+		value[2] ^= 1;
+		HostWrite(settings, value, settings.valueLength());
+		Loops(100);
+	}
+
+	SelectEffect(3);
+	for (int f = 0; f < 8; ++f)
+	{
+		for (const std::vector<uint8_t> &packet : packets[f])
+		{
+			HostWrite(streamCharacteristic, packet.data(), packet.size());
+		}
+		Loops(2);
+	}
+
+	CallFunction(4, 0);
+	CallFunction(5, 1);
+	Loops(100);
+	CallFunction(5, 0);
+	StoreCurrentSettings();
+	HostSubscribe(previewCharacteristic, false);
+	HostConnect(false);
+	Loops(100);
+
+	countAllocations = false;
+	CHECK_EQUAL(0, allocations);
+	CHECK(previewCharacteristic.local->writes > 0);
+	return HostTestResult("heap");
+}
@@ -0,0 +1,77 @@
+#include <ArduinoBLE.h>
+#include <ledlayout.h>
+
+#include "harness.h"
+
+using namespace GizmoLED;
+
+void TestRing()
+{
+	Layout layout;
+	LayoutRing(layout, 8);
+
+	// LED 0 points along the x axis, LED 4 opposite of it
+	const uint8_t *projection = GetLayoutProjection(layout, 0);
+	CHECK_EQUAL(255, projection[0]);
+	CHECK_EQUAL(0, projection[4]);
+	CHECK_EQUAL(128, projection[2]);
+
+	for (int i = 0; i < 8; ++i)
+	{
+		CHECK_EQUAL(i * 32, layout.polarAngle[i]);
+		CHECK_EQUAL(255, layout.polarRadius[i]);
+	}
+
+	// Quarter turn, LED 2 is now in front
+	projection = GetLayoutProjection(layout, 64);
+	CHECK_EQUAL(255, projection[2]);
+	CHECK_EQUAL(0, projection[6]);
+}
+
+void TestStrip()
+{
+	Layout layout;
+	LayoutStrip(layout, 5);
+
+	const uint8_t *projection = GetLayoutProjection(layout, 128);
+	CHECK_EQUAL(255, projection[0]);
+	CHECK_EQUAL(128, projection[2]);
+	CHECK_EQUAL(0, projection[4]);
+}
+
+void TestMatrix()
+{
+	Layout layout;
+	LayoutMatrix(layout, 3, 2, true);
+
+	// Second row runs backwards
+	CHECK(layout.x[0] < layout.x[1]);
+	CHECK(layout.x[3] > layout.x[4]);
+	CHECK_EQUAL(layout.x[0], layout.x[5]);
+	CHECK(layout.y[5] > layout.y[0]);
+}
+
+void TestEmpty()
+{
+	Layout layout;
+	LayoutPoints(layout, nullptr, 0);
+	CHECK_EQUAL(0, layout.numLeds);
+	GetLayoutProjection(layout, 10);
+}
+
+void TestAngleSlider()
+{
+	const uint8_t half[] = { 50, 0, 99 };
+	CHECK_EQUAL(128, GetLayoutAngle(half));
+	CHECK_EQUAL(0, GetLayoutAngle(nullptr));
+}
+
+int main()
+{
+	TestRing();
+	TestStrip();
+	TestMatrix();
+	TestEmpty();
+	TestAngleSlider();
+	return HostTestResult("ledlayout");
+}
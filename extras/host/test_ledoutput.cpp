@@ -0,0 +1,93 @@
+#include <ArduinoBLE.h>
+#include <ledoutput.h>
+
+#include "harness.h"
+
+using namespace GizmoLED;
+
+void TestGammaTable()
+{
+	double maxError = 0.0;
+	for (int i = 0; i < 256; ++i)
+	{
+		const double expected = pow(i / 255.0, OUTPUT_GAMMA) * 65535.0;
+		maxError = fmax(maxError, fabs(GammaTable::values[i] - expected));
+	}
+	CHECK(maxError <= 0.501);
+}
+
+void TestBrightness()
+{
+	SetOutputDithering(false);
+
+	uint8_t values[] = { 0, 128, 255 };
+	uint8_t out[3];
+	SetOutputBrightness(255);
+	ApplyOutput(values, out, 3);
+	CHECK_EQUAL(0, out[0]);
+	CHECK_EQUAL(GammaTable::values[128] >> 8, out[1]);
+	CHECK_EQUAL(255, out[2]);
+
+	SetOutputBrightness(127);
+	ApplyOutput(values, out, 3);
+	CHECK_EQUAL(127, out[2]);
+
+	SetOutputBrightness(0);
+	ApplyOutput(values, out, 3);
+	CHECK_EQUAL(0, out[2]);
+}
+
+void TestDitheringAverage()
+{
+	SetOutputDithering(true);
+
+	// The mean over the 8 frame cycle matches the 16 bit level within one step / 8
+	SetOutputBrightness(50);
+	for (int value = 1; value < 256; value += 7)
+	{
+		const uint8_t in = value;
+		int sum = 0;
+		for (int frame = 0; frame < 8; ++frame)
+		{
+			uint8_t out;
+			AdvanceOutputFrame();
+			ApplyOutput(&in, &out, 1);
+			sum += out;
+		}
+
+		const double expected = ((GammaTable::values[value] * 51) >> 8) / 256.0;
+		CHECK(fabs(sum / 8.0 - expected) <= 0.126);
+	}
+}
+
+void TestDitheringPerFrame()
+{
+	// Two strips output per frame both see the whole 8 frame threshold cycle
+	SetOutputBrightness(50);
+	const uint8_t in = 100;
+	const double expected = ((GammaTable::values[in] * 51) >> 8) / 256.0;
+	int sumA = 0;
+	int sumB = 0;
+	for (int frame = 0; frame < 8; ++frame)
+	{
+		uint8_t outA;
+		uint8_t outB;
+		AdvanceOutputFrame();
+		ApplyOutput(&in, &outA, 1);
+		ApplyOutput(&in, &outB, 1);
+		CHECK_EQUAL(outA, outB);
+		sumA += outA;
+		sumB += outB;
+	}
+	CHECK(fabs(sumA / 8.0 - expected) <= 0.126);
+	CHECK(fabs(sumB / 8.0 - expected) <= 0.126);
+}
+
+int main()
+{
+	TestGammaTable();
+	TestBrightness();
+	TestDitheringAverage();
+	TestDitheringPerFrame();
+	return HostTestResult("ledoutput");
+}
@@ -0,0 +1,122 @@
+#include <ArduinoBLE.h>
+#include <utility/ATT.h>
+#include <utility/HCI.h>
+#include <linkpolicy.h>
+
+#include "harness.h"
+
+using namespace GizmoLED;
+
+void AdvanceSeconds(int seconds, EffectType type)
+{
+	for (int i = 0; i < seconds; ++i)
+	{
+		HostAdvanceMicros(1000000);
+		UpdateLinkPolicy(type);
+	}
+}
+
+uint16_t AclWord(int offset)
+{
+	return HCI.lastAcl[offset] | (HCI.lastAcl[offset + 1] << 8);
+}
+
+void CheckRequest(const LinkPolicy &policy)
+{
+	CHECK_EQUAL(HOST_CONNECTION_HANDLE, HCI.lastAclHandle);
+	CHECK_EQUAL(0x0005, HCI.lastAclCid);
+	CHECK_EQUAL(12, HCI.lastAclLength);
+	CHECK_EQUAL(0x12, HCI.lastAcl[0]);
+	CHECK(HCI.lastAcl[1] != 0);
+	CHECK_EQUAL(8, AclWord(2));
+	CHECK_EQUAL(policy.minInterval, AclWord(4));
+	CHECK_EQUAL(policy.maxInterval, AclWord(6));
+	CHECK_EQUAL(policy.latency, AclWord(8));
+	CHECK_EQUAL(policy.supervisionTimeout, AclWord(10));
+}
+
+void TestRenegotiation()
+{
+	BeginLinkPolicy(EFFECTTYPE_DEFAULT);
+	CHECK_EQUAL(LINKPOLICY_INTERACTIVE, GetLinkPolicyName());
+
+	HostConnect(true);
+	LinkPolicyConnected(BLEDevice());
+	CHECK_EQUAL(0, GetLinkParameters().latency);
+	CHECK_EQUAL(linkPolicies[LINKPOLICY_INTERACTIVE].minInterval, GetLinkParameters().minInterval);
+	CHECK_EQUAL(0u, HCI.aclPackets);
+
+	// Going idle renegotiates the live connection, including latency
+	AdvanceSeconds(LINK_IDLE_TIME / 1000 + 2, EFFECTTYPE_DEFAULT);
+	CHECK_EQUAL(LINKPOLICY_IDLE, GetLinkPolicyName());
+	CHECK_EQUAL(1u, HCI.aclPackets);
+	CheckRequest(linkPolicies[LINKPOLICY_IDLE]);
+	CHECK_EQUAL(linkPolicies[LINKPOLICY_IDLE].latency, GetLinkParameters().latency);
+
+	const uint8_t identifier = HCI.lastAcl[1];
+	CHECK(UpdateLinkPolicy(EFFECTTYPE_STREAM, true));
+	CHECK_EQUAL(2u, HCI.aclPackets);
+	CheckRequest(linkPolicies[LINKPOLICY_REALTIME]);
+	CHECK(HCI.lastAcl[1] != identifier);
+}
+
+void TestRadioEventsUseLatencyInEffect()
+{
+	LinkPolicy parameters = linkPolicies[LINKPOLICY_IDLE];
+	const uint32_t withLatency = EstimateRadioEvents(parameters, true, 10000);
+	parameters.latency = 0;
+	const uint32_t withoutLatency = EstimateRadioEvents(parameters, true, 10000);
+	CHECK_EQUAL(withoutLatency, withLatency * (linkPolicies[LINKPOLICY_IDLE].latency + 1));
+
+	// Reconnecting drops the latency until the next request
+	LinkPolicyDisconnected();
+	HostConnect(false);
+	HostConnect(true);
+	LinkPolicyConnected(BLEDevice());
+	CHECK_EQUAL(0, GetLinkParameters().latency);
+
+	const uint32_t events = GetLinkPolicyStats(GetLinkPolicyName()).radioEvents;
+	AdvanceSeconds(10, EFFECTTYPE_STREAM);
+	const uint32_t expected = 10 * EstimateRadioEvents(GetLinkParameters(), true, 1000);
+	CHECK_EQUAL(expected, GetLinkPolicyStats(GetLinkPolicyName()).radioEvents - events);
+}
+
+void TestDisconnected()
+{
+	LinkPolicyDisconnected();
+	HostConnect(false);
+	const uint32_t packets = HCI.aclPackets;
+	AdvanceSeconds(LINK_IDLE_TIME / 1000 + 2, EFFECTTYPE_DEFAULT);
+	CHECK(UpdateLinkPolicy(EFFECTTYPE_DEFAULT, true) || GetLinkPolicyName() == LINKPOLICY_IDLE);
+	CHECK_EQUAL(packets, HCI.aclPackets);
+	CHECK_EQUAL(linkPolicies[LINKPOLICY_IDLE].advertisingInterval, BLE.advertisingInterval);
+}
+
+void TestEffectSwitchFromIdle()
+{
+	HostConnect(false);
+	AdvanceSeconds(LINK_IDLE_TIME / 1000 + 10, EFFECTTYPE_DEFAULT);
+	CHECK_EQUAL(LINKPOLICY_IDLE, GetLinkPolicyName());
+
+	// One write just after an evaluation is not a realtime write rate
+	HostAdvanceMicros(10000);
+	LinkPolicyNotifyWrite();
+	UpdateLinkPolicy(EFFECTTYPE_DEFAULT, true);
+	CHECK(GetLinkPolicyName() != LINKPOLICY_REALTIME);
+
+	AdvanceSeconds(3, EFFECTTYPE_DEFAULT);
+	CHECK_EQUAL(LINKPOLICY_INTERACTIVE, GetLinkPolicyName());
+
+	// A streaming effect switches right away
+	CHECK(UpdateLinkPolicy(EFFECTTYPE_STREAM, true));
+	CHECK_EQUAL(LINKPOLICY_REALTIME, GetLinkPolicyName());
+}
+
+int main()
+{
+	TestRenegotiation();
+	TestRadioEventsUseLatencyInEffect();
+	TestDisconnected();
+	TestEffectSwitchFromIdle();
+	return HostTestResult("linkpolicy");
+}
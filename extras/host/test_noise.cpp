@@ -0,0 +1,219 @@
+#include <ArduinoBLE.h>
+#include <noise.h>
+#include <set>
+
+#include "harness.h"
+
+using namespace GizmoLED;
+
+// Pearson chi-square of byte counts against a uniform distribution, 255 degrees of freedom
+double ChiSquare(const uint32_t *histogram, uint32_t total)
+{
+	const double expected = total / 256.0;
+	double chi = 0.0;
+	for (int i = 0; i < 256; ++i)
+	{
+		const double d = histogram[i] - expected;
+		chi += d * d / expected;
+	}
+	return chi;
+}
+
+void TestDeterminism()
+{
+	Random a, b;
+	RandomSeed(a, 12345);
+	RandomSeed(b, 12345);
+	for (int i = 0; i < 1000; ++i)
+	{
+		CHECK_EQUAL(Random32(a), Random32(b));
+	}
+
+	// Known first outputs of xorshift32 so the sequence can't change unnoticed
+	Random c;
+	RandomSeed(c, 1);
+	CHECK_EQUAL(270369u, Random32(c));
+	CHECK_EQUAL(67634689u, Random32(c));
+
+	// Seed 0 is mapped to a valid state instead of producing zeros forever
+	Random zero;
+	RandomSeed(zero, 0);
+	CHECK(Random32(zero) != 0);
+
+	for (uint32_t x = 0; x < 100000; x += 997)
+	{
+		CHECK_EQUAL(ValueNoise1D(x, 7), ValueNoise1D(x, 7));
+		CHECK_EQUAL(SimplexNoise2D(x, x * 3, 7), SimplexNoise2D(x, x * 3, 7));
+	}
+
+	int different = 0;
+	for (uint32_t x = 0; x < 100 * 256; x += 256)
+	{
+		different += ValueNoise1D(x, 1) != ValueNoise1D(x, 2);
+	}
+	CHECK(different > 90);
+}
+
+void TestFillMatchesRandom32()
+{
+	for (int count = 0; count < 13; ++count)
+	{
+		Random fill, single;
+		RandomSeed(fill, 99);
+		RandomSeed(single, 99);
+
+		uint8_t bytes[16];
+		RandomFill(fill, bytes, count);
+
+		for (int i = 0; i < count; i += 4)
+		{
+			const uint32_t x = Random32(single);
+			for (int b = 0; b < 4 && i + b < count; ++b)
+			{
+				CHECK_EQUAL(uint8_t(x >> (b * 8)), bytes[i + b]);
+			}
+		}
+		CHECK_EQUAL(single.state, fill.state);
+	}
+}
+
+void TestFillKeepsState()
+{
+	// Every tail length has to keep the full 32 bit state, repeated fills must not cycle
+	for (int count = 296; count < 300; ++count)
+	{
+		Random random;
+		RandomSeed(random, 12345);
+
+		std::set<uint32_t> states;
+		uint8_t bytes[300];
+		for (int i = 0; i < 10000; ++i)
+		{
+			RandomFill(random, bytes, count);
+			states.insert(random.state);
+		}
+		CHECK_EQUAL(10000, states.size());
+	}
+}
+
+void TestDistribution()
+{
+	Random random;
+	RandomSeed(random, 2024);
+
+	// Strip sized fills with odd lengths, the 0.1% critical values for 255 dof are about 190 and 330
+	uint32_t histogram[256] = {};
+	uint8_t bytes[299];
+	uint32_t total = 0;
+	for (int i = 0; i < 4000; ++i)
+	{
+		RandomFill(random, bytes, sizeof bytes);
+		for (uint8_t b : bytes)
+		{
+			++histogram[b];
+		}
+		total += sizeof bytes;
+	}
+	const double chi = ChiSquare(histogram, total);
+	CHECK(chi > 190.0 && chi < 330.0);
+
+	// Ranged values stay in range and hit every value
+	uint32_t counts[10] = {};
+	int outOfRange = 0;
+	for (int i = 0; i < 100000; ++i)
+	{
+		const uint8_t value = Random8(random, 10);
+		if (value < 10)
+		{
+			++counts[value];
+		}
+		else
+		{
+			++outOfRange;
+		}
+	}
+	CHECK_EQUAL(0, outOfRange);
+	for (int i = 0; i < 10; ++i)
+	{
+		CHECK(counts[i] > 9000 && counts[i] < 11000);
+	}
+
+	// Noise is centered and uses most of the output range
+	for (int type = 0; type < 4; ++type)
+	{
+		uint64_t sum = 0;
+		int low = 255, high = 0, count = 0;
+		for (uint32_t y = 0; y < 64 * 256; y += 256 + 17)
+		{
+			for (uint32_t x = 0; x < 256 * 256; x += 97)
+			{
+				uint8_t value;
+				switch (type)
+				{
+				case 0: value = ValueNoise1D(x + y * 256, 3); break;
+				case 1: value = ValueNoise2D(x, y, 3); break;
+				case 2: value = SimplexNoise1D(x + y * 256, 3); break;
+				default: value = SimplexNoise2D(x, y, 3); break;
+				}
+				sum += value;
+				low = min(low, int(value));
+				high = max(high, int(value));
+				++count;
+			}
+		}
+
+		const double mean = double(sum) / count;
+		CHECK(mean > 112.0 && mean < 144.0);
+		CHECK(high - low > 180);
+	}
+}
+
+void TestContinuity()
+{
+	// Neighboring samples 1/256 of a cell apart only move a little, also far from the origin
+	const uint32_t bases[] = { 0, 1000000, 0x7FFF0000u, 0xF0000000u };
+	for (uint32_t base : bases)
+	{
+		int maxStep1D = 0, maxStep2D = 0;
+		int last1D = SimplexNoise1D(base, 5);
+		int last2D = SimplexNoise2D(base, base / 3, 5);
+		for (uint32_t i = 1; i < 20000; ++i)
+		{
+			const int value1D = SimplexNoise1D(base + i, 5);
+			const int value2D = SimplexNoise2D(base + i, base / 3 + i / 2, 5);
+			maxStep1D = max(maxStep1D, abs(value1D - last1D));
+			maxStep2D = max(maxStep2D, abs(value2D - last2D));
+			last1D = value1D;
+			last2D = value2D;
+		}
+		CHECK(maxStep1D <= 8);
+		CHECK(maxStep2D <= 8);
+	}
+}
+
+void TestBatchMatchesSingle()
+{
+	uint8_t values[64];
+	SimplexNoiseFill2D(values, 64, 1000, 2000, 37, 11, 9);
+	for (int i = 0; i < 64; ++i)
+	{
+		CHECK_EQUAL(SimplexNoise2D(1000 + i * 37, 2000 + i * 11, 9), values[i]);
+	}
+
+	ValueNoiseFill1D(values, 64, 500, 29, 4);
+	for (int i = 0; i < 64; ++i)
+	{
+		CHECK_EQUAL(ValueNoise1D(500 + i * 29, 4), values[i]);
+	}
+}
+
+int main()
+{
+	TestDeterminism();
+	TestFillMatchesRandom32();
+	TestFillKeepsState();
+	TestDistribution();
+	TestContinuity();
+	TestBatchMatchesSingle();
+	return HostTestResult("noise");
+}
@@ -0,0 +1,149 @@
+#include <ArduinoBLE.h>
+#include <parallelencoder.h>
+
+#include "harness.h"
+
+// Built twice by the Makefile, the _scalar build runs the portable path
+
+using namespace GizmoLED;
+
+#define MAX_STRIPS 24
+#define MAX_BYTES 301
+
+uint8_t stripData[MAX_STRIPS][MAX_BYTES];
+const uint8_t *strips[MAX_STRIPS];
+uint8_t encoded[MAX_BYTES * 8 * 3];
+uint8_t expected[MAX_BYTES * 8 * 3];
+
+// One bit at a time, the output layout spelled out
+void NaiveEncodeLanes(const uint8_t *const *strips, int numStrips, int numBytes, uint8_t *out)
+{
+	const int numLanes = (numStrips + PARALLEL_STRIPS_PER_LANE - 1) / PARALLEL_STRIPS_PER_LANE;
+	memset(out, 0, numBytes * 8 * numLanes);
+	for (int s = 0; s < numStrips; ++s)
+	{
+		if (strips[s] == nullptr)
+			continue;
+
+		const int lane = s / PARALLEL_STRIPS_PER_LANE;
+		for (int i = 0; i < numBytes; ++i)
+		{
+			for (int bit = 0; bit < 8; ++bit)
+			{
+				if (strips[s][i] & (0x80 >> bit))
+				{
+					out[(i * 8 + bit) * numLanes + lane] |= 1 << (s % PARALLEL_STRIPS_PER_LANE);
+				}
+			}
+		}
+	}
+}
+
+void ResetStrips()
+{
+	for (int s = 0; s < MAX_STRIPS; ++s)
+	{
+		for (int i = 0; i < MAX_BYTES; ++i)
+		{
+			stripData[s][i] = uint8_t(random(256));
+		}
+		strips[s] = stripData[s];
+	}
+}
+
+void TestEncode()
+{
+	ResetStrips();
+	strips[3] = nullptr;
+
+	// Odd byte counts end in the per byte tail of the SIMD path
+	int mismatches = 0;
+	for (int numStrips = 1; numStrips <= PARALLEL_STRIPS_PER_LANE; ++numStrips)
+	{
+		for (int numBytes : { 0, 1, 2, 7, MAX_BYTES })
+		{
+			memset(encoded, 0xAA, sizeof encoded);
+			ParallelEncode(strips, numStrips, numBytes, encoded);
+			NaiveEncodeLanes(strips, numStrips, numBytes, expected);
+			mismatches += memcmp(encoded, expected, numBytes * 8) != 0;
+			mismatches += encoded[numBytes * 8] != 0xAA;
+		}
+	}
+	CHECK_EQUAL(0, mismatches);
+
+	// Strips past the lane are ignored
+	ParallelEncode(strips, MAX_STRIPS, MAX_BYTES, encoded);
+	NaiveEncodeLanes(strips, PARALLEL_STRIPS_PER_LANE, MAX_BYTES, expected);
+	CHECK(memcmp(encoded, expected, MAX_BYTES * 8) == 0);
+}
+
+void TestSlices()
+{
+	const uint8_t one = 0x80;
+	const uint8_t zero = 0x00;
+	const uint8_t *pair[2] = { &one, &zero };
+	ParallelEncode(pair, 2, 1, encoded);
+	CHECK_EQUAL(0x01, encoded[0]);
+	CHECK_EQUAL(0x00, encoded[1]);
+
+	const uint8_t alternating = 0x55;
+	const uint8_t *single[1] = { &alternating };
+	ParallelEncode(single, 1, 1, encoded);
+	CHECK_EQUAL(0x00, encoded[0]);
+	CHECK_EQUAL(0x01, encoded[1]);
+	CHECK_EQUAL(0x01, encoded[7]);
+}
+
+void TestEncodeLanes()
+{
+	ResetStrips();
+	strips[9] = nullptr;
+	strips[20] = nullptr;
+
+	int mismatches = 0;
+	for (int numStrips = 1; numStrips <= MAX_STRIPS; ++numStrips)
+	{
+		const int numLanes = (numStrips + PARALLEL_STRIPS_PER_LANE - 1) / PARALLEL_STRIPS_PER_LANE;
+		for (int numBytes : { 1, 3, MAX_BYTES })
+		{
+			memset(encoded, 0xAA, sizeof encoded);
+			ParallelEncodeLanes(strips, numStrips, numBytes, encoded);
+			NaiveEncodeLanes(strips, numStrips, numBytes, expected);
+			mismatches += memcmp(encoded, expected, numBytes * 8 * numLanes) != 0;
+			if (numBytes * 8 * numLanes < int(sizeof encoded))
+			{
+				mismatches += encoded[numBytes * 8 * numLanes] != 0xAA;
+			}
+		}
+	}
+	CHECK_EQUAL(0, mismatches);
+
+	// One lane is the same stream as ParallelEncode
+	ParallelEncodeLanes(strips, PARALLEL_STRIPS_PER_LANE, MAX_BYTES, encoded);
+	ParallelEncode(strips, PARALLEL_STRIPS_PER_LANE, MAX_BYTES, expected);
+	CHECK(memcmp(encoded, expected, MAX_BYTES * 8) == 0);
+}
+
+void TestExpandWS2812()
+{
+	const uint8_t slices[] = { 0x00, 0xFF, 0x5A };
+	uint8_t out[sizeof slices * PARALLEL_WS2812_SLOTS];
+	ParallelExpandWS2812(slices, sizeof slices, out);
+
+	const uint8_t expectedOut[] = { 0xFF, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0xFF, 0x5A, 0x00 };
+	CHECK(memcmp(out, expectedOut, sizeof out) == 0);
+}
+
+int main()
+{
+	randomSeed(39);
+	TestEncode();
+	TestSlices();
+	TestEncodeLanes();
+	TestExpandWS2812();
+#if defined(__SSE2__) && !defined(PARALLEL_NO_SIMD)
+	return HostTestResult("parallelencoder (SSE2)");
+#else
+	return HostTestResult("parallelencoder (scalar)");
+#endif
+}
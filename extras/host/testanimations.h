@@ -0,0 +1,105 @@
+#pragma once
+
+// Typical effect output used as input by the stream and preview tests and benchmarks
+
+#include <Arduino.h>
+#include <colorutilities.h>
+
+enum TestAnimation
+{
+	TESTANIMATION_SOLID = 0, // One color that never changes
+	TESTANIMATION_RAINBOW, // Every pixel changes every frame
+	TESTANIMATION_METEOR, // Short bright tail moving over black
+	TESTANIMATION_SPARKLE, // A few random pixels change per frame
+	TESTANIMATION_PULSE, // Whole strip fades in one color
+	NUM_TESTANIMATIONS,
+};
+
+inline const char *GetTestAnimationName(int animation)
+{
+	static const char *names[NUM_TESTANIMATIONS] = { "solid", "rainbow", "meteor", "sparkle", "pulse" };
+	return names[animation];
+}
+
+// 256 entry rainbow, rainbow frames only use colors from it
+inline const uint8_t (*GetTestRainbowPalette())[3]
+{
+	static uint8_t palette[256][3];
+	static bool baked = false;
+	if (!baked)
+	{
+		for (int i = 0; i < 256; ++i)
+		{
+			HSV2RGB(i * 360.0f / 256, 100.0f, 100.0f, palette[i]);
+		}
+		baked = true;
+	}
+	return palette;
+}
+
+inline void RenderTestAnimation(int animation, int frameIndex, uint8_t *frame, int numPixels)
+{
+	switch (animation)
+	{
+	case TESTANIMATION_SOLID:
+		for (int i = 0; i < numPixels; ++i)
+		{
+			frame[i * 3] = 255;
+			frame[i * 3 + 1] = 80;
+			frame[i * 3 + 2] = 0;
+		}
+		break;
+
+	case TESTANIMATION_RAINBOW:
+		for (int i = 0; i < numPixels; ++i)
+		{
+			memcpy(frame + i * 3, GetTestRainbowPalette()[uint8_t(i * 256 / numPixels + frameIndex * 3)], 3);
+		}
+		break;
+
+	case TESTANIMATION_METEOR:
+	{
+		memset(frame, 0, numPixels * 3);
+		const int head = frameIndex % numPixels;
+		for (int t = 0; t < 12 && head - t >= 0; ++t)
+		{
+			const uint8_t level = 255 - t * 20;
+			frame[(head - t) * 3] = level;
+			frame[(head - t) * 3 + 1] = level;
+			frame[(head - t) * 3 + 2] = level / 2;
+		}
+	}
+	break;
+
+	case TESTANIMATION_SPARKLE:
+	{
+		if (frameIndex == 0)
+		{
+			memset(frame, 10, numPixels * 3);
+		}
+		uint32_t x = 0x9E3779B9 ^ (frameIndex * 2654435761u);
+		for (int s = 0; s < numPixels / 20 + 1; ++s)
+		{
+			x ^= x << 13;
+			x ^= x >> 17;
+			x ^= x << 5;
+			uint8_t *pixel = frame + (x % numPixels) * 3;
+			const uint8_t level = (x >> 24) & 1 ? 255 : 10;
+			pixel[0] = pixel[1] = pixel[2] = level;
+		}
+	}
+	break;
+
+	default:
+	{
+		const uint8_t level = uint8_t(127 + 127 * sin(frameIndex * 0.1));
+		for (int i = 0; i < numPixels; ++i)
+		{
+			frame[i * 3] = 0;
+			frame[i * 3 + 1] = level;
+			frame[i * 3 + 2] = level;
+		}
+	}
+	break;
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Integer math for effects: angles are 16 bit (65536 per turn) or 8 bit (256 per turn),
+// fractions are 8 bit (256 == 1.0) unless noted otherwise.
+
+namespace GizmoLED
+{
+	// Time passed to fixed point effects
+	struct FixedFrameTime
+	{
+		uint32_t micros; // Timebase in microseconds, wraps after ~71 minutes
+		uint32_t delta; // Seconds since the last frame, Q16
+		uint32_t phase; // Seconds since the timebase started, Q16, wraps after ~18 hours. Shared with the sync master.
+	};
+
+	extern const int16_t sinQuarterTable[65];
+
+	// Returns Q15, -32767 to 32767
+	inline int16_t Sin16(uint16_t angle)
+	{
+		uint16_t quarterAngle = angle & 0x3FFF;
+		if (angle & 0x4000)
+		{
+			quarterAngle = 0x4000 - quarterAngle;
+		}
+
+		// 64 table segments with linear interpolation
+		const uint8_t index = quarterAngle >> 8;
+		const uint8_t fraction = quarterAngle & 0xFF;
+		int32_t value = sinQuarterTable[index];
+		if (fraction != 0)
+		{
+			value += ((sinQuarterTable[index + 1] - value) * fraction) >> 8;
+		}
+
+		return (angle & 0x8000) ? -value : value;
+	}
+
+	inline int16_t Cos16(uint16_t angle)
+	{
+		return Sin16(angle + 0x4000);
+	}
+
+	// Returns 0-255 centered at 128
+	inline uint8_t Sin8(uint8_t angle)
+	{
+		return (Sin16(angle << 8) + 32768) >> 8;
+	}
+
+	inline uint8_t Cos8(uint8_t angle)
+	{
+		return Sin8(angle + 64);
+	}
+
+	inline uint8_t Scale8(uint8_t value, uint8_t scale)
+	{
+		return (uint16_t(value) * (uint16_t(scale) + 1)) >> 8;
+	}
+
+	inline uint16_t Scale16(uint16_t value, uint16_t scale)
+	{
+		return (uint32_t(value) * (uint32_t(scale) + 1)) >> 16;
+	}
+
+	inline uint8_t Lerp8(uint8_t a, uint8_t b, uint8_t fraction)
+	{
+		return a + ((int16_t(b - a) * fraction) >> 8);
+	}
+
+	// The full range difference times fraction needs 32 unsigned bits
+	inline uint16_t Lerp16(uint16_t a, uint16_t b, uint16_t fraction)
+	{
+		if (b >= a)
+			return a + ((uint32_t(b - a) * fraction) >> 16);
+		return a - ((uint32_t(a - b) * fraction) >> 16);
+	}
+
+	inline uint8_t Ease8InQuad(uint8_t t)
+	{
+		return Scale8(t, t);
+	}
+
+	inline uint8_t Ease8OutQuad(uint8_t t)
+	{
+		return 255 - Ease8InQuad(255 - t);
+	}
+
+	inline uint8_t Ease8InOutQuad(uint8_t t)
+	{
+		const uint8_t half = (t & 0x80) ? 255 - t : t;
+		const uint8_t eased = Scale8(half, half) << 1;
+		return (t & 0x80) ? 255 - eased : eased;
+	}
+
+	inline uint8_t Ease8InOutCubic(uint8_t t)
+	{
+		// 3t^2 - 2t^3 with t in 1/256 steps, kept at full precision so it never decreases
+		const uint32_t t2 = uint32_t(t) * t;
+		return (t2 * (768 - 2 * t)) >> 16;
+	}
+
+	// Phase of a periodic animation running at frequency (Q16 Hz), 65536 per cycle
+	inline uint16_t GetPhase16(const FixedFrameTime &time, uint32_t frequency)
+	{
+		return (uint64_t(time.phase) * frequency) >> 16;
+	}
+}
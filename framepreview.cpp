@@ -0,0 +1,95 @@
+#include <ArduinoBLE.h>
+
+#include "framepreview.h"
+#include "gizmoled.h"
+
+using namespace GizmoLED;
+
+inline uint8_t QuantizeRGB332(uint16_t r, uint16_t g, uint16_t b)
+{
+	return (r & 0xE0) | ((g >> 3) & 0x1C) | (b >> 6);
+}
+
+// Averages the pixels covered by each point
+void PreviewDownsample(const uint8_t *frame, uint16_t numPixels, uint8_t numPoints, uint8_t *points)
+{
+	for (int p = 0; p < numPoints; ++p)
+	{
+		const int begin = p * numPixels / numPoints;
+		const int end = MAX(begin + 1, (p + 1) * numPixels / numPoints);
+
+		uint32_t r = 0, g = 0, b = 0;
+		for (int i = begin; i < end; ++i)
+		{
+			r += frame[i * 3];
+			g += frame[i * 3 + 1];
+			b += frame[i * 3 + 2];
+		}
+
+		const int count = end - begin;
+		points[p] = QuantizeRGB332(r / count, g / count, b / count);
+	}
+}
+
+namespace GizmoLED
+{
+	void PreviewReset(PreviewEncoder &encoder)
+	{
+		encoder.hasPrevious = false;
+		encoder.framesSinceKeyframe = 0;
+	}
+
+	int PreviewEncode(PreviewEncoder &encoder, const uint8_t *frame, uint16_t numPixels,
+		uint8_t numPoints, uint8_t *packet)
+	{
+		numPoints = MIN(MIN(numPoints, PREVIEW_MAX_POINTS), numPixels);
+		if (numPoints == 0)
+			return 0;
+
+		uint8_t points[PREVIEW_MAX_POINTS];
+		PreviewDownsample(frame, numPixels, numPoints, points);
+
+		const bool keyframe = !encoder.hasPrevious ||
+			encoder.numPoints != numPoints ||
+			encoder.framesSinceKeyframe >= PREVIEW_KEYFRAME_INTERVAL;
+
+		uint8_t *write = packet + PREVIEW_HEADER_SIZE;
+		if (keyframe)
+		{
+			memcpy(write, points, numPoints);
+			write += numPoints;
+			encoder.framesSinceKeyframe = 0;
+		}
+		else
+		{
+			uint8_t *mask = write;
+			const int maskSize = (numPoints + 7) / 8;
+			memset(mask, 0, maskSize);
+			write += maskSize;
+
+			for (int p = 0; p < numPoints; ++p)
+			{
+				if (points[p] != encoder.points[p])
+				{
+					mask[p >> 3] |= 1 << (p & 7);
+					*write++ = points[p];
+				}
+			}
+
+			if (write == mask + maskSize)
+				return 0;
+
+			++encoder.framesSinceKeyframe;
+		}
+
+		packet[0] = keyframe ? PREVIEWPACKET_KEYFRAME : 0;
+		packet[1] = encoder.sequence++;
+		packet[2] = numPoints;
+
+		memcpy(encoder.points, points, numPoints);
+		encoder.numPoints = numPoints;
+		encoder.hasPrevious = true;
+
+		return write - packet;
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <Arduino.h>
+
+#define PREVIEW_MAX_POINTS 64
+#define PREVIEW_KEYFRAME_INTERVAL 16
+#define PREVIEW_HEADER_SIZE 3
+#define PREVIEW_MAX_PACKET (PREVIEW_HEADER_SIZE + PREVIEW_MAX_POINTS / 8 + PREVIEW_MAX_POINTS)
+
+namespace GizmoLED
+{
+	// Packet: flags, sequence number, number of points, then either one RGB332 byte per point
+	// (keyframe) or a bitmask of changed points followed by their RGB332 bytes (delta)
+	enum PreviewPacketFlags
+	{
+		PREVIEWPACKET_KEYFRAME = 1 << 0,
+	};
+
+	struct PreviewEncoder
+	{
+		uint8_t points[PREVIEW_MAX_POINTS];
+		uint8_t numPoints;
+		uint8_t sequence;
+		uint8_t framesSinceKeyframe;
+		bool hasPrevious;
+	};
+
+	extern void PreviewReset(PreviewEncoder &encoder);
+
+	// Downsamples and encodes frame (RGB, 3 bytes per pixel) into packet.
+	// Returns the packet length or 0 if the preview did not change.
+	extern int PreviewEncode(PreviewEncoder &encoder, const uint8_t *frame, uint16_t numPixels,
+		uint8_t numPoints, uint8_t *packet);
+}
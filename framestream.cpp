@@ -0,0 +1,170 @@
+#include <ArduinoBLE.h>
+
+#include "framestream.h"
+
+using namespace GizmoLED;
+
+inline void StreamWritePixel(uint8_t *frame, uint16_t numPixels, uint16_t index, const uint8_t *rgb)
+{
+	if (index < numPixels)
+	{
+		uint8_t *pixel = frame + index * 3;
+		pixel[0] = rgb[0];
+		pixel[1] = rgb[1];
+		pixel[2] = rgb[2];
+	}
+}
+
+void StreamDecodePalette(StreamDecoder &decoder, const uint8_t *data, int length)
+{
+	if (length < 1)
+		return;
+
+	int index = data[0];
+	for (int i = 1; i + 3 <= length && index < STREAM_PALETTE_SIZE; i += 3, ++index)
+	{
+		decoder.palette[index][0] = data[i];
+		decoder.palette[index][1] = data[i + 1];
+		decoder.palette[index][2] = data[i + 2];
+	}
+}
+
+void StreamDecodeOps(StreamDecoder &decoder, const uint8_t *data, int length,
+	uint8_t *frame, uint16_t numPixels)
+{
+	int pos = 0;
+	while (pos < length)
+	{
+		if (decoder.remaining == 0)
+		{
+			const uint8_t b = data[pos++];
+			decoder.op = b & 0xC0;
+			decoder.remaining = (b & 0x3F) + 1;
+			decoder.partialCount = 0;
+
+			if (decoder.op == STREAMOP_SKIP)
+			{
+				decoder.cursor += decoder.remaining;
+				decoder.remaining = 0;
+			}
+			continue;
+		}
+
+		switch (decoder.op)
+		{
+		case STREAMOP_LITERAL:
+		{
+			// Fast path, copy all whole pixels of this op that are in the packet
+			if (decoder.partialCount == 0 && decoder.cursor < numPixels)
+			{
+				int count = MIN(decoder.remaining, (length - pos) / 3);
+				count = MIN(count, numPixels - decoder.cursor);
+				if (count > 0)
+				{
+					memcpy(frame + decoder.cursor * 3, data + pos, count * 3);
+					pos += count * 3;
+					decoder.cursor += count;
+					decoder.remaining -= count;
+					continue;
+				}
+			}
+
+			decoder.partial[decoder.partialCount++] = data[pos++];
+			if (decoder.partialCount == 3)
+			{
+				StreamWritePixel(frame, numPixels, decoder.cursor++, decoder.partial);
+				decoder.partialCount = 0;
+				--decoder.remaining;
+			}
+		}
+		break;
+
+		case STREAMOP_RUN:
+		{
+			decoder.partial[decoder.partialCount++] = data[pos++];
+			if (decoder.partialCount == 3)
+			{
+				for (; decoder.remaining > 0; --decoder.remaining)
+				{
+					StreamWritePixel(frame, numPixels, decoder.cursor++, decoder.partial);
+				}
+				decoder.partialCount = 0;
+			}
+		}
+		break;
+
+		case STREAMOP_INDEXED:
+		{
+			StreamWritePixel(frame, numPixels, decoder.cursor++, decoder.palette[data[pos++]]);
+			--decoder.remaining;
+		}
+		break;
+		}
+	}
+}
+
+namespace GizmoLED
+{
+	void StreamReset(StreamDecoder &decoder)
+	{
+		decoder.synced = false;
+		decoder.inFrame = false;
+		decoder.cursor = 0;
+		decoder.remaining = 0;
+		decoder.partialCount = 0;
+	}
+
+	bool StreamDecodePacket(StreamDecoder &decoder, const uint8_t *data, int length,
+		uint8_t *frame, uint16_t numPixels)
+	{
+		if (length < 2)
+			return false;
+
+		const uint8_t flags = data[0];
+		const uint8_t sequence = data[1];
+
+		// A lost packet breaks the op stream and the delta base, wait for the next keyframe
+		if (decoder.synced && sequence != decoder.expectedSequence)
+		{
+			++decoder.packetsDropped;
+			StreamReset(decoder);
+		}
+		decoder.expectedSequence = sequence + 1;
+
+		if (flags & STREAMPACKET_PALETTE)
+		{
+			StreamDecodePalette(decoder, data + 2, length - 2);
+			return false;
+		}
+
+		if (!decoder.synced)
+		{
+			const uint8_t keyframeStart = STREAMPACKET_FRAMESTART | STREAMPACKET_KEYFRAME;
+			if ((flags & keyframeStart) != keyframeStart)
+				return false;
+
+			decoder.synced = true;
+		}
+
+		if (flags & STREAMPACKET_FRAMESTART)
+		{
+			decoder.inFrame = true;
+			decoder.cursor = 0;
+			decoder.remaining = 0;
+			decoder.partialCount = 0;
+		}
+
+		if (!decoder.inFrame)
+			return false;
+
+		StreamDecodeOps(decoder, data + 2, length - 2, frame, numPixels);
+
+		if (flags & STREAMPACKET_FRAMEEND)
+		{
+			decoder.inFrame = false;
+			++decoder.framesDecoded;
+			return true;
+		}
+		return false;
+	}
+}
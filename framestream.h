@@ -0,0 +1,56 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <gizmoled.h>
+
+#define STREAM_MAX_PACKET 244 // Max ATT write payload with data length extension
+#define STREAM_PALETTE_SIZE 256
+#define STREAM_OP_MAX_PIXELS 64
+
+namespace GizmoLED
+{
+	// Packet: flags, sequence number, then ops or palette entries.
+	// A frame can span any number of packets, ops may be split between them.
+	enum StreamPacketFlags
+	{
+		STREAMPACKET_FRAMESTART = 1 << 0,
+		STREAMPACKET_FRAMEEND = 1 << 1,
+		STREAMPACKET_KEYFRAME = 1 << 2, // Frame doesn't depend on the previous frame
+		STREAMPACKET_PALETTE = 1 << 3, // Payload is start index followed by RGB entries
+	};
+
+	// Op byte, the low 6 bits hold the pixel count - 1
+	enum StreamOp
+	{
+		STREAMOP_LITERAL = 0x00, // RGB per pixel
+		STREAMOP_SKIP = 0x40, // Pixels unchanged from the previous frame
+		STREAMOP_RUN = 0x80, // One RGB for all pixels
+		STREAMOP_INDEXED = 0xC0, // Palette index per pixel
+	};
+
+	struct StreamDecoder
+	{
+		uint8_t expectedSequence;
+		bool synced; // False after packet loss until the next keyframe
+		bool inFrame;
+
+		uint16_t cursor;
+		uint8_t op;
+		uint8_t remaining;
+		uint8_t partial[3];
+		uint8_t partialCount;
+
+		uint8_t palette[STREAM_PALETTE_SIZE][3];
+
+		// Statistics
+		uint32_t framesDecoded;
+		uint32_t packetsDropped;
+	};
+
+	extern void StreamReset(StreamDecoder &decoder);
+
+	// Decodes straight into frame (RGB, 3 bytes per pixel). Returns true when a frame was completed.
+	extern bool StreamDecodePacket(StreamDecoder &decoder, const uint8_t *data, int length,
+		uint8_t *frame, uint16_t numPixels);
+}
@@ -2,6 +2,13 @@
 #include <ArduinoBLE.h>
 
 #include "gizmoled.h"
+#include "colorpalette.h"
+#include "framestream.h"
+#include "framepreview.h"
+#include "linkpolicy.h"
+#include "clocksync.h"
+#include "ledoutput.h"
+#include "effectclass.h"
 
 //#include <Wire.h>
 //#include <extEEPROM.h>
@@ -22,10 +29,14 @@ using namespace GizmoLED;
 //#define NUM_LEDS 101
 
 #define BLE_DELAY 0.1f
-#define BLE_DELAY_VISUALIZER 0.0f
 #define EEP_ROM_PAGE_SIZE 128
 #define CONNECTION_FX_TIME 1.5f
 #define AUDIO_HOLD_TIME 10.0f
+#define IDLE_DELAY 100 // Max sleep in ms while the current frame is unchanged
+#define FPS_MEASURE_WINDOW 1000000 // us
+#define FPS_ADAPT_STEP 5
+#define PREVIEW_DEFAULT_RATE 10 // Hz
+#define PREVIEW_MAX_INTERVAL 1000000 // us, slowest rate while upstream traffic is busy
 
 // Persisted data
 #define GENERIC_INIT_MAGIC 0x47
@@ -56,7 +67,9 @@ namespace GizmoLED
 {
 	float audioData[NUM_AUDIO_POINTS] = { 0.0f };
 	FnConnectionAnimation connectionAnimation = nullptr;
+	FnConnectionAnimationFixed connectionAnimationFixed = nullptr;
 	FnEffectChangedCallback effectChangedCallback = nullptr;
+	const EffectClassDispatch *effectClassDispatch = nullptr; // Set by GIZMOLED_EFFECT_ARENA
 }
 
 #define MAX_FNCALL_ARGS 32
@@ -79,7 +92,11 @@ BLECharacteristic effectTypeCharacteristic(PROGMEM "e8942ca1-d9e7-4c45-b96c-10cf
 
 // Upstream BLE
 BLECharacteristic audioDataCharacteristic(PROGMEM "e8942ca1-d9e7-4c45-b96c-20cf850bfa00", BLEWrite | BLEWriteWithoutResponse, sizeof audioData);
-BLECharacteristic fnCallCharacteristic(PROGMEM "e8942ca1-d9e7-4c45-b96c-20cf850bfa01", BLEWrite, sizeof functionCallState + MAX_FNCALL_ARGS);
+BLECharacteristic fnCallCharacteristic(PROGMEM "e8942ca1-d9e7-4c45-b96c-20cf850bfa01", BLERead | BLEWrite, sizeof functionCallState + MAX_FNCALL_ARGS);
+BLECharacteristic streamCharacteristic(PROGMEM "e8942ca1-d9e7-4c45-b96c-20cf850bfa02", BLEWrite | BLEWriteWithoutResponse, STREAM_MAX_PACKET);
+
+// Downstream BLE
+BLECharacteristic previewCharacteristic(PROGMEM "e8942ca1-d9e7-4c45-b96c-30cf850bfa00", BLERead | BLENotify, PREVIEW_MAX_PACKET);
 
 // EEP
 //extEEPROM eep(kbits_256, 1, EEP_ROM_PAGE_SIZE);
@@ -91,10 +108,13 @@ BLECharacteristic fnCallCharacteristic(PROGMEM "e8942ca1-d9e7-4c45-b96c-20cf850b
 
 Effect *effects = nullptr;
 int numEffects = 0;
+EffectStats effectStats[MAX_NUMBER_EFFECTS] = {};
 
-int lastTime = 0;
+unsigned long lastMicros = 0;
+uint64_t timebaseMicros = 0;
 int animationDelayCompensation = 0;
 float frameTime = 0.0f;
+FixedFrameTime fixedFrameTime = {};
 float bleUpdateTimer = 0;
 float bleCurrentUpdateDelay = BLE_DELAY;
 
@@ -102,13 +122,194 @@ float connectionEffectTimer = 0.0f;
 float lastAudioTime = 0.0f;
 float settingsDirtyTimer = 0.0f;
 
+// Static frame skipping
+bool frameValid = false;
+bool frameUnchangedReported = false;
+bool frameSkipped = false;
+Effect *lastRenderedEffect = nullptr;
+Effect *activeEffect = nullptr;
+uint64_t idleMicros = 0; // 32 bits would wrap after ~71 minutes
+uint64_t loopMicros = 0;
+
+// Frame rate
+Effect *animatedEffect = nullptr;
+Effect *measuredEffect = nullptr;
+unsigned long fpsWindowStart = 0;
+uint16_t fpsWindowFrames = 0;
+
+// Frame streaming
+uint8_t *frameBuffer = nullptr;
+uint16_t frameBufferPixels = 0;
+StreamDecoder streamDecoder;
+
+// Frame preview
+PreviewEncoder previewEncoder;
+bool previewSubscribed = false;
+bool previewPending = false; // The current frame has not been sent yet
+uint8_t previewPoints = PREVIEW_MAX_POINTS;
+unsigned long previewBaseInterval = 1000000UL / PREVIEW_DEFAULT_RATE;
+unsigned long previewInterval = 1000000UL / PREVIEW_DEFAULT_RATE;
+unsigned long lastPreviewTime = 0;
+uint16_t upstreamWrites = 0;
+uint32_t previewEncodeMicros = 0; // Smoothed encoder cost
+uint32_t previewBytesSent = 0;
+
 BLEDevice central;
 
+EffectStats &GetStats(const Effect *effect)
+{
+	return effectStats[effect - effects];
+}
+
+int GetVarSize(uint8_t type)
+{
+	switch (type)
+	{
+	case VARTYPE_COLOR:
+	case VARTYPE_SLIDER:
+		return 3;
+	case VARTYPE_CHECKBOX:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+// Checks if a settings write touches any var that palettes are baked from
+bool HasPaletteChanged(const Effect &effect, const uint8_t *value)
+{
+	int pos = 0;
+	while (pos + 2 <= effect.settingsSize)
+	{
+		const int size = GetVarSize(effect.settings[pos]);
+		if (size == 0)
+			break;
+
+		if (IsPaletteVar(VarName(effect.settings[pos + 1])) &&
+			memcmp(effect.settings + pos + 2, value + pos + 2, MIN(size, effect.settingsSize - pos - 2)) != 0)
+		{
+			return true;
+		}
+		pos += 2 + size;
+	}
+	return false;
+}
+
+namespace GizmoLED
+{
+	const uint8_t noEffectVar[3] = { 0 };
+
+	void SetFrameBuffer(uint8_t *rgb, uint16_t numPixels)
+	{
+		frameBuffer = rgb;
+		frameBufferPixels = numPixels;
+	}
+
+	Effect *FindEffect(EffectName name)
+	{
+		for (int i = 0; i < numEffects; ++i)
+		{
+			if (effects[i].name == name)
+				return &effects[i];
+		}
+		return nullptr;
+	}
+
+	const EffectStats &GetEffectStats(const Effect &effect)
+	{
+		return GetStats(&effect);
+	}
+
+	uint8_t *FindEffectVar(const Effect &effect, VarName name)
+	{
+		int pos = 0;
+		while (pos + 2 <= effect.settingsSize)
+		{
+			const int size = GetVarSize(effect.settings[pos]);
+			if (size == 0 || pos + 2 + size > effect.settingsSize)
+				break;
+
+			if (effect.settings[pos + 1] == name)
+				return effect.settings + pos + 2;
+
+			pos += 2 + size;
+		}
+		return nullptr;
+	}
+
+	void SetFrameUnchanged()
+	{
+		frameUnchangedReported = true;
+	}
+
+	void InvalidateFrame()
+	{
+		frameValid = false;
+	}
+
+	float GetIdlePercentage()
+	{
+		if (loopMicros == 0)
+			return 0.0f;
+
+		return float(idleMicros) * 100.0f / float(loopMicros);
+	}
+
+	void PrintDiagnostics()
+	{
+		Serial.println("Idle: " + String(GetIdlePercentage()) + "%");
+		for (int i = 0; i < numEffects; ++i)
+		{
+			Effect &effect = effects[i];
+			const EffectStats &stats = effectStats[i];
+			Serial.println("Effect " + String(effect.name) +
+				" rendered: " + String(stats.framesRendered) +
+				", skipped: " + String(stats.framesSkipped) +
+				", fps: " + String(stats.achievedFps) +
+				" (" + String(stats.currentFps) + "/" + String(effect.targetFps) + ")" +
+				", render: " + String(stats.renderMicros) + "us");
+		}
+
+		Serial.println("Arena: " + String((unsigned long)GetArenaUsed()) +
+			", peak: " + String((unsigned long)GetArenaPeak()) +
+			" of " + String((unsigned long)GetArenaSize()) + " bytes");
+
+		PrintLinkPolicyStats();
+		PrintClockSyncStats();
+
+		Serial.println("Preview: " + String(previewSubscribed ? 1000000UL / previewInterval : 0UL) + "Hz" +
+			", encode: " + String(previewEncodeMicros) + "us" +
+			", sent: " + String(previewBytesSent) + " bytes");
+	}
+}
+
 void SetVisualizerInputSupported(bool isSupported)
 {
 	BLE.setAdvertisedService(isSupported ? ledServiceADV : ledServiceAD);
 }
 
+EffectType GetSelectedEffectType()
+{
+	return genericData.selectedEffect < numEffects ?
+		effects[genericData.selectedEffect].type : EFFECTTYPE_DEFAULT;
+}
+
+// Picks link parameters and BLE poll rate from the effect type and write traffic
+void UpdateLink(bool immediate)
+{
+	if (UpdateLinkPolicy(GetSelectedEffectType(), immediate))
+	{
+		bleCurrentUpdateDelay = GetLinkPolicy().bleUpdateDelay;
+		bleUpdateTimer = MIN(bleUpdateTimer, bleCurrentUpdateDelay);
+	}
+}
+
+void NotifyUpstreamWrite()
+{
+	++upstreamWrites;
+	LinkPolicyNotifyWrite();
+}
+
 void MakeSettingsDirty()
 {
 	settingsDirtyTimer = 5.0f;
@@ -116,6 +317,8 @@ void MakeSettingsDirty()
 
 void EffectTypeChanged(BLEDevice device, BLECharacteristic characteristic)
 {
+	NotifyUpstreamWrite();
+
 	uint8_t effectIndex = *(const uint8_t*)characteristic.value();
 	if (effectIndex >= numEffects) {
 		return;
@@ -142,8 +345,14 @@ void EffectTypeChanged(BLEDevice device, BLECharacteristic characteristic)
 	}
 #endif
 
-	bleCurrentUpdateDelay = (effect.type == EFFECTTYPE_VISUALIZER) ? BLE_DELAY_VISUALIZER : BLE_DELAY;
+	UpdateLink(true);
+
+	if (effect.type == EFFECTTYPE_STREAM)
+	{
+		StreamReset(streamDecoder);
+	}
 	
+	InvalidateFrame();
 	MakeSettingsDirty();
 	
 	if (effectChangedCallback != nullptr)
@@ -154,6 +363,8 @@ void EffectTypeChanged(BLEDevice device, BLECharacteristic characteristic)
 
 void EffectSettingsChanged(BLEDevice device, BLECharacteristic characteristic)
 {
+	NotifyUpstreamWrite();
+
 	//Serial.println("effect changed");
 	Effect *effect = nullptr;
 	for (int i = 0; i < numEffects; ++i)
@@ -188,12 +399,18 @@ void EffectSettingsChanged(BLEDevice device, BLECharacteristic characteristic)
 
 	//Serial.println("Changing characteristic: " + String(effect->name));
 	const uint8_t *value = characteristic.value();
+	if (HasPaletteChanged(*effect, value))
+	{
+		InvalidatePalettes(effect->name);
+	}
+
 	for (int i = 0; i < characteristic.valueLength(); ++i)
 	{
 		effect->settings[i] = value[i];
 		//Serial.println("v: " + String(value[i]));
 	}
 	
+	InvalidateFrame();
 	MakeSettingsDirty();
 
 	//if (EEP_SAVE_CHANGES == 1)
@@ -221,6 +438,7 @@ void ResetSettings(uint8_t effectIndex)
 
 	Effect &effect = effects[effectIndex];
 	effect.characteristic->writeValue(effect.defaultSettings, effect.settingsSize);
+	InvalidateFrame();
 }
 
 void RenameDevice(const uint8_t *args, int len)
@@ -253,6 +471,8 @@ void RenameDevice(const uint8_t *args, int len)
 //int audioFrame = 0;
 void AudioDataChanged(BLEDevice device, BLECharacteristic characteristic)
 {
+	NotifyUpstreamWrite();
+
 	if (1 != characteristic.valueLength())
 	{
 		return;
@@ -287,10 +507,125 @@ void AudioDataChanged(BLEDevice device, BLECharacteristic characteristic)
 	{
 		lastAudioTime = AUDIO_HOLD_TIME;
 	}
+
+	InvalidateFrame();
+}
+
+void StreamDataChanged(BLEDevice device, BLECharacteristic characteristic)
+{
+	NotifyUpstreamWrite();
+
+	if (frameBuffer == nullptr ||
+		genericData.selectedEffect >= numEffects ||
+		effects[genericData.selectedEffect].type != EFFECTTYPE_STREAM)
+	{
+		return;
+	}
+
+	if (StreamDecodePacket(streamDecoder, characteristic.value(), characteristic.valueLength(),
+		frameBuffer, frameBufferPixels))
+	{
+		// Completed frames are shown on the next render tick
+		InvalidateFrame();
+	}
+}
+
+void SetPreviewRate(const uint8_t *args, int len)
+{
+	if (len < 1 || args[0] == 0)
+		return;
+
+	previewBaseInterval = 1000000UL / args[0];
+	previewInterval = previewBaseInterval;
+
+	if (len >= 2 && args[1] > 0)
+	{
+		previewPoints = MIN(args[1], PREVIEW_MAX_POINTS);
+	}
+}
+
+void PreviewSubscribed(BLEDevice device, BLECharacteristic characteristic)
+{
+	previewSubscribed = true;
+	previewPending = true;
+	PreviewReset(previewEncoder);
+}
+
+void PreviewUnsubscribed(BLEDevice device, BLECharacteristic characteristic)
+{
+	previewSubscribed = false;
+}
+
+// Notifies a downsampled copy of the frame, backing off while upstream writes are busy
+void UpdatePreview()
+{
+	if (!previewSubscribed || !previewPending || frameBuffer == nullptr)
+		return;
+
+	const unsigned long now = micros();
+	if (now - lastPreviewTime < previewInterval)
+		return;
+
+	lastPreviewTime = now;
+	previewPending = false;
+
+	if (upstreamWrites > 0)
+	{
+		previewInterval = MIN(previewInterval * 2, PREVIEW_MAX_INTERVAL);
+		upstreamWrites = 0;
+	}
+	else if (previewInterval > previewBaseInterval)
+	{
+		previewInterval = MAX(previewInterval / 2, previewBaseInterval);
+	}
+
+	uint8_t packet[PREVIEW_MAX_PACKET];
+	const int length = PreviewEncode(previewEncoder, frameBuffer, frameBufferPixels, previewPoints, packet);
+	previewEncodeMicros = (previewEncodeMicros * 7 + (micros() - now)) / 8;
+
+	if (length > 0)
+	{
+		previewCharacteristic.writeValue(packet, length);
+		previewBytesSent += length;
+	}
+}
+
+// Max time to sleep in ms so an owed preview still goes out on time
+unsigned long GetPreviewDelayMillis()
+{
+	if (!previewSubscribed || !previewPending)
+		return IDLE_DELAY;
+
+	const unsigned long elapsed = micros() - lastPreviewTime;
+	if (elapsed >= previewInterval)
+		return 0;
+
+	return MIN((previewInterval - elapsed + 999) / 1000, (unsigned long)IDLE_DELAY);
+}
+
+// Memory usage is returned in the function call characteristic after the call state
+void ReportMemoryUsage()
+{
+	const uint16_t values[] = {
+		uint16_t(GetArenaUsed()),
+		uint16_t(GetArenaPeak()),
+		uint16_t(GetArenaSize()),
+	};
+
+	uint8_t report[sizeof functionCallState + sizeof values];
+	copySmall(report, functionCallState, sizeof functionCallState);
+	for (unsigned int i = 0; i < sizeof values / sizeof values[0]; ++i)
+	{
+		report[sizeof functionCallState + i * 2] = values[i] & 0xFF;
+		report[sizeof functionCallState + i * 2 + 1] = values[i] >> 8;
+	}
+	fnCallCharacteristic.writeValue(report, sizeof report);
 }
 
 void FnCallChanged(BLEDevice device, BLECharacteristic characteristic)
 {
+	NotifyUpstreamWrite();
+
 	const int fnStateLength = sizeof functionCallState;
 	const int dataLength = characteristic.valueLength() - fnStateLength;
 	if (characteristic.valueLength() < fnStateLength)
@@ -321,6 +656,33 @@ void FnCallChanged(BLEDevice device, BLECharacteristic characteristic)
 			RenameDevice(characteristic.value() + fnStateLength, nameLength);
 		}
 		break;
+
+		case 2:
+		{
+			PrintDiagnostics();
+		}
+		break;
+
+		case 3:
+		{
+			SetPreviewRate(characteristic.value() + fnStateLength, dataLength);
+		}
+		break;
+
+		case 4:
+		{
+			ReportMemoryUsage();
+		}
+		break;
+
+		case 5:
+		{
+			if (dataLength >= 1 && value[2] <= SYNCROLE_FOLLOWER)
+			{
+				SetSyncRole(SyncRole(value[2]));
+			}
+		}
+		break;
 		}
 	}
 }
@@ -328,14 +690,86 @@ void FnCallChanged(BLEDevice device, BLECharacteristic characteristic)
 // Connection FX
 void ConnectionFX()
 {
-	if (connectionAnimation != nullptr)
+	const float percent = (CONNECTION_FX_TIME - connectionEffectTimer) / CONNECTION_FX_TIME;
+	if (connectionAnimationFixed != nullptr)
+	{
+		connectionAnimationFixed(fixedFrameTime, uint16_t(MIN(percent, 1.0f) * 65535.0f));
+	}
+	else if (connectionAnimation != nullptr)
+	{
+		connectionAnimation(frameTime, percent);
+	}
+}
+
+unsigned long GetFrameDelayMicros()
+{
+	uint8_t fps = (animatedEffect != nullptr) ? GetStats(animatedEffect).currentFps : DEFAULT_TARGET_FPS;
+	return 1000000UL / fps;
+}
+
+void AdaptFrameRate(Effect *effect, unsigned long renderCost)
+{
+	EffectStats &stats = GetStats(effect);
+
+	// Smooth the render cost so single slow frames don't change the rate
+	stats.renderMicros = (stats.renderMicros * 7 + renderCost) / 8;
+
+	unsigned long budget = 1000000UL / stats.currentFps;
+	if (stats.renderMicros > budget - budget / 10)
+	{
+		stats.currentFps = MAX(effect->minFps, stats.currentFps - FPS_ADAPT_STEP);
+	}
+	else if (stats.renderMicros < budget / 2 &&
+		stats.currentFps < effect->targetFps)
+	{
+		++stats.currentFps;
+	}
+}
+
+void MeasureFrameRate(Effect *effect, unsigned long now)
+{
+	if (effect != measuredEffect)
+	{
+		measuredEffect = effect;
+		fpsWindowStart = now;
+		fpsWindowFrames = 0;
+		return;
+	}
+
+	++fpsWindowFrames;
+
+	unsigned long elapsed = now - fpsWindowStart;
+	if (elapsed >= FPS_MEASURE_WINDOW)
+	{
+		GetStats(effect).achievedFps = fpsWindowFrames * 1000000.0f / elapsed;
+		fpsWindowStart = now;
+		fpsWindowFrames = 0;
+	}
+}
+
+// Runs the end and begin hooks when the rendered effect changes
+void ActivateEffect(Effect *effect)
+{
+	if (effect == activeEffect)
+		return;
+
+	if (activeEffect != nullptr && activeEffect->effectClass != 0)
+	{
+		effectClassDispatch->end(activeEffect->effectClass - 1, *activeEffect);
+	}
+
+	activeEffect = effect;
+
+	if (effect != nullptr && effect->effectClass != 0)
 	{
-		connectionAnimation(frameTime, (CONNECTION_FX_TIME - connectionEffectTimer) / CONNECTION_FX_TIME);
+		effectClassDispatch->begin(effect->effectClass - 1, *effect);
 	}
 }
 
 void Animate()
 {
+	animatedEffect = nullptr;
+
 	if (connectionEffectTimer > 0.0f)
 	{
 		ConnectionFX();
@@ -345,6 +779,10 @@ void Animate()
 		{
 			connectionEffectTimer = 0.0f;
 		}
+
+		// Effect must redraw once the connection FX ends
+		lastRenderedEffect = nullptr;
+		frameValid = false;
 	}
 	else
 	{
@@ -377,9 +815,46 @@ void Animate()
 				}
 			}
 
+			ActivateEffect(effect);
+
 			if (effect != nullptr)
 			{
-				effect->fnEffectAnimation(frameTime);
+				animatedEffect = effect;
+
+				// Streamed frames are only shown once fully decoded
+				const bool isStreaming = effect->type == EFFECTTYPE_STREAM;
+				if ((frameValid && effect == lastRenderedEffect) ||
+					(isStreaming && streamDecoder.inFrame))
+				{
+					++GetStats(effect).framesSkipped;
+					frameSkipped = true;
+					return;
+				}
+
+				frameUnchangedReported = false;
+
+				unsigned long renderStart = micros();
+				if (effect->effectClass != 0)
+				{
+					effectClassDispatch->render(effect->effectClass - 1, frameTime, fixedFrameTime);
+				}
+				else if (effect->fnEffectAnimationFixed != nullptr)
+				{
+					effect->fnEffectAnimationFixed(fixedFrameTime);
+				}
+				else
+				{
+					effect->fnEffectAnimation(frameTime);
+				}
+				unsigned long renderEnd = micros();
+
+				++GetStats(effect).framesRendered;
+				AdaptFrameRate(effect, renderEnd - renderStart);
+				MeasureFrameRate(effect, renderEnd);
+
+				lastRenderedEffect = effect;
+				frameValid = frameUnchangedReported || isStreaming ||
+					(effect->flags & EFFECTFLAG_STATIC) != 0;
 			}
 		}
 	}
@@ -395,6 +870,7 @@ void UpdateBLE()
 
 	//Serial.println(String("update ble " + String(millis())));
 	BLE.poll();
+	LinkPolicyNotifyPoll();
 
 	//central = BLE.central();
 	//if (central)
@@ -435,15 +911,24 @@ void blePeripheralConnectedHandler(BLEDevice device)
 
 	//Serial.println("connected central: " + central.deviceName() + central.localName());
 	connectionEffectTimer = CONNECTION_FX_TIME;
+	InvalidateFrame();
 
 	// Reset function call trigger
 	functionCallState[0] = 0;
+
+	// Subscriptions don't persist across connections
+	previewSubscribed = false;
+
+	LinkPolicyConnected(device);
+}
+
+void blePeripheralDisconnectedHandler(BLEDevice device)
+{
+	//Serial.print("Disconnected event, device: ");
+	//Serial.println(device.address());
+
+	LinkPolicyDisconnected();
 }
-//
-//void blePeripheralDisconnectedHandler(BLEDevice device) {
-//	//Serial.print("Disconnected event, device: ");
-//	//Serial.println(device.address());
-//}
 
 int GetTotalEEPROMSize()
 {
@@ -461,7 +946,13 @@ void StoreCurrentSettings()
 	//Serial.println("Flashing settings...");
 
 #ifdef ARDUINO_ARCH_NRF52840
-	uint8_t *data = (uint8_t*)malloc(flashBlockSize);
+	const size_t arenaMark = ArenaMark();
+	uint8_t *data = ArenaAllocArray<uint8_t>(flashBlockSize);
+	if (data == nullptr)
+	{
+		Serial.println("GizmoLED settings not saved, increase GIZMOLED_ARENA_SIZE");
+		return;
+	}
 
 	genericData.isInitialized = GENERIC_INIT_MAGIC;
 	copySmall(data, (uint8_t*)&genericData, sizeof(struct Generic));
@@ -474,7 +965,7 @@ void StoreCurrentSettings()
 	
 	BLEFLASH_WRITE(flashAll, flashBlockSize, data);
 
-	free(data);
+	ArenaRelease(arenaMark);
 #elif ESP32
 	int totalSize = GetTotalEEPROMSize();
 	EEPROM.begin(totalSize);
@@ -498,22 +989,65 @@ void StoreCurrentSettings()
 #endif
 }
 
+// Settings characteristics live in the arena, uuids end in the effect index.
+// Returns false when the arena is too small for them.
+bool CreateEffectCharacteristics()
+{
+	static const char uuidBase[] = "e8942ca1-d9e7-4c45-b96c-10cf850bfa";
+	const int uuidBaseLength = sizeof uuidBase - 1;
+	for (int e = 0; e < numEffects; ++e)
+	{
+		Effect &effect = effects[e];
+		char *uuid = ArenaAllocArray<char>(uuidBaseLength + 3);
+		void *storage = ArenaAllocArray<BLECharacteristic>(1);
+		if (uuid == nullptr || storage == nullptr)
+			return false;
+
+		memcpy(uuid, uuidBase, uuidBaseLength);
+		uuid[uuidBaseLength] = '0' + e / 10;
+		uuid[uuidBaseLength + 1] = '0' + e % 10;
+		uuid[uuidBaseLength + 2] = 0;
+		effect.characteristic = new (storage) BLECharacteristic(uuid, BLERead | BLEWrite, effect.settingsSize);
+	}
+	return true;
+}
+
 void GizmoLEDSetup()
 {
 	Serial.begin(115200);
 	Serial.setTimeout(50);
 
 
-	// BLE init
-	BLE.setConnectionInterval(0x0001, 0x0001);
+	// BLE init, link parameters are set once the selected effect is known
 	BLE.begin();
 	BLE.setLocalName(defaultDeviceName);
 
-	for (int i = 0; i < numEffects; ++i)
+	bool allocated = CreateEffectCharacteristics();
+	for (int i = 0; i < numEffects && allocated; ++i)
 	{
 		Effect &effect = effects[i];
-		effect.defaultSettings = new uint8_t[effect.settingsSize];
+		effect.defaultSettings = ArenaAllocArray<uint8_t>(effect.settingsSize);
+		if (effect.defaultSettings == nullptr)
+		{
+			allocated = false;
+			break;
+		}
+
 		copySmall(effect.defaultSettings, effect.settings, effect.settingsSize);
+
+		if (effect.targetFps == 0)
+			effect.targetFps = DEFAULT_TARGET_FPS;
+		effect.minFps = MIN(MAX(effect.minFps, 1), effect.targetFps);
+		effectStats[i].currentFps = effect.targetFps;
+	}
+
+	// Effects can't run without their characteristics and default settings.
+	// Optional allocations that failed earlier, like a layout, don't stop setup.
+	while (!allocated)
+	{
+		Serial.println("GizmoLED setup failed, arena exhausted. Increase GIZMOLED_ARENA_SIZE (" +
+			String((unsigned long)GetArenaSize()) + " bytes)");
+		delay(1000);
 	}
 
 	// Flash init
@@ -635,7 +1169,10 @@ void GizmoLEDSetup()
 	}
 
 	Serial.println("Continue Init 1");
-	bleCurrentUpdateDelay = (effects[genericData.selectedEffect].type == EFFECTTYPE_VISUALIZER) ? BLE_DELAY_VISUALIZER : BLE_DELAY;
+	BeginLinkPolicy(GetSelectedEffectType());
+	bleCurrentUpdateDelay = GetLinkPolicy().bleUpdateDelay;
+	BLE.setConnectionInterval(GetLinkPolicy().minInterval, GetLinkPolicy().maxInterval);
+	BLE.setSupervisionTimeout(GetLinkPolicy().supervisionTimeout);
 
 	//genericData.visualizerFlags = 0;
 	genericData.numberOfEffects = numEffects;
@@ -667,6 +1204,8 @@ void GizmoLEDSetup()
 	ledService.addCharacteristic(effectTypeCharacteristic);
 	ledService.addCharacteristic(audioDataCharacteristic);
 	ledService.addCharacteristic(fnCallCharacteristic);
+	ledService.addCharacteristic(streamCharacteristic);
+	ledService.addCharacteristic(previewCharacteristic);
 
 	// Characteristics init
 	effectTypeCharacteristic.writeValue((byte*)&genericData, sizeof(struct Generic));
@@ -676,6 +1215,9 @@ void GizmoLEDSetup()
 	effectTypeCharacteristic.setEventHandler(BLEWritten, EffectTypeChanged);
 	audioDataCharacteristic.setEventHandler(BLEWritten, AudioDataChanged);
 	fnCallCharacteristic.setEventHandler(BLEWritten, FnCallChanged);
+	streamCharacteristic.setEventHandler(BLEWritten, StreamDataChanged);
+	previewCharacteristic.setEventHandler(BLESubscribed, PreviewSubscribed);
+	previewCharacteristic.setEventHandler(BLEUnsubscribed, PreviewUnsubscribed);
 
 	Serial.println("Continue Init 4");
 	
@@ -686,12 +1228,12 @@ void GizmoLEDSetup()
 	SetVisualizerInputSupported(genericData.selectedEffect < numEffects &&
 		effects[genericData.selectedEffect].type == EFFECTTYPE_VISUALIZER);
 
-	BLE.setAdvertisingInterval(320); // 160 == 100ms
+	BLE.setAdvertisingInterval(GetLinkPolicy().advertisingInterval); // 160 == 100ms
 	BLE.advertise();
 
 	Serial.println("Continue Init 5");
 	BLE.setEventHandler(BLEConnected, blePeripheralConnectedHandler);
-	//BLE.setEventHandler(BLEDisconnected, blePeripheralDisconnectedHandler);
+	BLE.setEventHandler(BLEDisconnected, blePeripheralDisconnectedHandler);
 	
 	if (effectChangedCallback != nullptr)
 	{
@@ -703,18 +1245,57 @@ void GizmoLEDSetup()
 
 void GizmoLEDLoop()
 {
-	int currentTime = millis();
-	frameTime = (currentTime - lastTime) / 1000.0f;
-	int animationDelay = lastTime = currentTime;
+	unsigned long loopStart = micros();
+	unsigned long deltaMicros = loopStart - lastMicros;
+	lastMicros = loopStart;
 
-	if (frameTime >= 1.0f)
+	if (deltaMicros >= 1000000UL)
 	{
-		frameTime = 0.999f;
+		deltaMicros = 999000UL;
 	}
 
+	// Phase is derived from the 64 bit timebase so rounding never accumulates.
+	// When following a sync master it is mapped to the master's phase.
+	timebaseMicros += deltaMicros;
+	const uint32_t localPhase = uint32_t((timebaseMicros << 16) / 1000000UL);
+	const uint32_t phase = UpdateClockSync(localPhase,
+		genericData.selectedEffect < numEffects ? effects[genericData.selectedEffect].name : 0);
+	const int32_t phaseDelta = int32_t(phase - fixedFrameTime.phase);
+	fixedFrameTime.micros = uint32_t(timebaseMicros);
+	fixedFrameTime.delta = phaseDelta > 0 ? phaseDelta : 0;
+	fixedFrameTime.phase = phase;
+
+	frameTime = deltaMicros / 1000000.0f;
+	AdvanceOutputFrame();
+
+	frameSkipped = false;
 	Animate();
+	if (!frameSkipped)
+	{
+		previewPending = true;
+	}
 
-	UpdateBLE();
+	// Dithered output changes every frame even when the effect doesn't render
+	const bool idle = frameSkipped && !IsOutputDitheringActive();
+	if (idle)
+	{
+		// Nothing to draw, sleep until the next BLE event or timeout.
+		// Any write that changes the output invalidates the frame.
+		// A frame rendered within the last preview interval is still owed to the subscriber.
+		UpdatePreview();
+		unsigned long idleStart = micros();
+		BLE.poll(GetPreviewDelayMillis());
+		LinkPolicyNotifyPoll();
+		idleMicros += micros() - idleStart;
+		bleUpdateTimer = bleCurrentUpdateDelay;
+	}
+	else
+	{
+		UpdatePreview();
+		UpdateBLE();
+	}
+
+	UpdateLink(false);
 	
 	if (settingsDirtyTimer > 0.0f)
 	{
@@ -725,15 +1306,26 @@ void GizmoLEDLoop()
 		}
 	}
 
-	animationDelay = ANIMATION_DELAY - (millis() - animationDelay);
+	long frameDelay = GetFrameDelayMicros();
+	long animationDelay = frameDelay - long(micros() - loopStart);
 	if (animationDelay < 0)
 	{
 		animationDelay = 0;
 	}
-	else if (animationDelay > ANIMATION_DELAY)
+	else if (animationDelay > frameDelay)
 	{
-		animationDelay = ANIMATION_DELAY;
+		animationDelay = frameDelay;
 	}
-	delay(animationDelay);
+
+	if (!idle)
+	{
+		// delay() alone would cut up to 1ms off every frame
+		unsigned long idleStart = micros();
+		delay(animationDelay / 1000);
+		delayMicroseconds(animationDelay % 1000);
+		idleMicros += micros() - idleStart;
+	}
+
+	loopMicros += micros() - loopStart;
 }
 
@@ -4,10 +4,14 @@
 #include <Arduino.h>
 
 #include <colorutilities.h>
+#include <arena.h>
+#include <fixedmath.h>
 
 #define MAX_NUMBER_EFFECTS 24
 #define NUM_AUDIO_POINTS 6
-#define ANIMATION_DELAY int(1000/60) // FPS
+#define DEFAULT_TARGET_FPS 60
+#define DEFAULT_MIN_FPS 30
+#define ANIMATION_DELAY int(1000/DEFAULT_TARGET_FPS)
 
 #ifndef MAX
 #define MAX(x, y) ((x) >= (y) ? (x) : (y))
@@ -78,6 +82,13 @@ namespace GizmoLED
 	{
 		EFFECTTYPE_DEFAULT = 0,
 		EFFECTTYPE_VISUALIZER,
+		EFFECTTYPE_STREAM, // Shows frames streamed over BLE into the frame buffer
+	};
+
+	enum EffectFlags
+	{
+		EFFECTFLAG_NONE = 0,
+		EFFECTFLAG_STATIC = 1 << 0, // Output only changes when settings change
 	};
 
 	//struct Var
@@ -88,8 +99,22 @@ namespace GizmoLED
 
 	typedef void(*FnEffectAnimation)(float frameTime);
 	typedef void(*FnConnectionAnimation)(float frameTime, float percent);
+
+	// Integer alternatives, percent is Q16
+	typedef void(*FnEffectAnimationFixed)(const FixedFrameTime &time);
+	typedef void(*FnConnectionAnimationFixed)(const FixedFrameTime &time, uint16_t percent);
 	typedef void(*FnEffectChangedCallback)(int newEffectType, int lastEffectType);
 
+	struct Effect;
+
+	// Calls into the effect classes of the sketch by their index in GIZMOLED_EFFECT_ARENA
+	struct EffectClassDispatch
+	{
+		void(*begin)(uint8_t index, Effect &effect);
+		void(*render)(uint8_t index, float frameTime, const FixedFrameTime &time);
+		void(*end)(uint8_t index, Effect &effect);
+	};
+
 	struct Effect
 	{
 		EffectType type;
@@ -102,10 +127,50 @@ namespace GizmoLED
 
 		BLECharacteristic *characteristic;
 		FnEffectAnimation fnEffectAnimation;
+		uint8_t flags;
+		uint8_t targetFps;
+		uint8_t minFps;
+
+		// Used instead of fnEffectAnimation when set
+		FnEffectAnimationFixed fnEffectAnimationFixed;
+
+		// Index + 1 of the effect class in GIZMOLED_EFFECT_ARENA, 0 for animation functions
+		uint8_t effectClass;
+	};
+
+	// Runtime state of an effect, kept apart so the effect table stays a plain declaration
+	struct EffectStats
+	{
+		// Frame rate currently scheduled, lowered when rendering exceeds the frame budget
+		uint8_t currentFps;
+
+		uint32_t framesRendered;
+		uint32_t framesSkipped;
+		float achievedFps;
+		uint32_t renderMicros; // Smoothed render cost per frame
 	};
 
+	// Called from an effect animation to report that its output will not change
+	// until settings change, so following frames can be skipped
+	extern void SetFrameUnchanged();
+	extern void InvalidateFrame();
+
+	// RGB pixels shown by the sketch, stream effects decode into it
+	extern void SetFrameBuffer(uint8_t *rgb, uint16_t numPixels);
+
+	extern Effect *FindEffect(EffectName name);
+	extern const EffectStats &GetEffectStats(const Effect &effect);
+
+	// Returns the values of a var inside the effect settings or nullptr
+	extern uint8_t *FindEffectVar(const Effect &effect, VarName name);
+
+	extern float GetIdlePercentage();
+	extern void PrintDiagnostics();
+
 	extern GizmoLED::FnConnectionAnimation connectionAnimation;
+	extern GizmoLED::FnConnectionAnimationFixed connectionAnimationFixed;
 	extern GizmoLED::FnEffectChangedCallback effectChangedCallback;
+	extern const GizmoLED::EffectClassDispatch *effectClassDispatch;
 	extern float audioData[NUM_AUDIO_POINTS];
 	//extern bool *audioDecay;
 }
@@ -156,29 +221,40 @@ namespace GizmoLED
 
 // (PROGMEM (uuid), BLERead | BLEWrite, sizeof name ## Settings),\
 
-#define DECLARE_EFFECT(variableName, animationFunction, type) \
+// Every field is listed so declarations stay free of missing initializer warnings
+#define DECLARE_EFFECT_ENTRY(variableName, type, animationFunction, animationFunctionFixed, effectClass, flags, targetFps, minFps) \
 	{type, fx ## variableName::e, fx ## variableName::e + 2, \
 	sizeof variableName ## Data, variableName ## Data, nullptr, \
 	nullptr, \
-	animationFunction},
+	animationFunction, flags, targetFps, minFps, \
+	animationFunctionFixed, \
+	effectClass},
+
+#define DECLARE_EFFECT_EX(variableName, animationFunction, type, flags, targetFps, minFps) \
+	DECLARE_EFFECT_ENTRY(variableName, type, animationFunction, nullptr, 0, flags, targetFps, minFps)
+
+#define DECLARE_EFFECT_FLAGS(variableName, animationFunction, type, flags) \
+	DECLARE_EFFECT_EX(variableName, animationFunction, type, flags, DEFAULT_TARGET_FPS, DEFAULT_MIN_FPS)
+
+#define DECLARE_EFFECT_FPS(variableName, animationFunction, type, targetFps, minFps) \
+	DECLARE_EFFECT_EX(variableName, animationFunction, type, GizmoLED::EFFECTFLAG_NONE, targetFps, minFps)
+
+#define DECLARE_EFFECT_FIXED_EX(variableName, animationFunction, type, flags, targetFps, minFps) \
+	DECLARE_EFFECT_ENTRY(variableName, type, nullptr, animationFunction, 0, flags, targetFps, minFps)
+
+#define DECLARE_EFFECT_FIXED(variableName, animationFunction, type) \
+	DECLARE_EFFECT_FIXED_EX(variableName, animationFunction, type, GizmoLED::EFFECTFLAG_NONE, DEFAULT_TARGET_FPS, DEFAULT_MIN_FPS)
+
+#define DECLARE_EFFECT(variableName, animationFunction, type) \
+	DECLARE_EFFECT_FLAGS(variableName, animationFunction, type, GizmoLED::EFFECTFLAG_NONE)
+
+#define DECLARE_STATIC_EFFECT(variableName, animationFunction, type) \
+	DECLARE_EFFECT_FLAGS(variableName, animationFunction, type, GizmoLED::EFFECTFLAG_STATIC)
 
 #define GIZMOLED_SETUP() \
 	{ \
 		extern int numEffects; \
 		numEffects = sizeof _effects / (sizeof _effects[0]); \
-		String uuidBase(PROGMEM "e8942ca1-d9e7-4c45-b96c-10cf850bfa"); \
-		for (int e; e < numEffects; ++e) { \
-			GizmoLED::Effect &effect = _effects[e]; \
-			String tempUuid = String(uuidBase + (e < 10 ? String("0") + String(e) : String(e))); \
-			char *uuid = (char*)malloc(tempUuid.length() + 1); \
-			const char *rd = tempUuid.c_str(); \
-			char *wr = uuid; \
-			while (*rd) { *wr = *rd; ++wr; ++rd; } \
-			*wr = 0; \
-			effect.characteristic = new BLECharacteristic( \
-				uuid, \
-				BLERead | BLEWrite, effect.settingsSize); \
-		} \
 		extern GizmoLED::Effect *effects; \
 		effects = _effects; \
 	} \
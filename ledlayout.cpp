@@ -0,0 +1,193 @@
+#include <ArduinoBLE.h>
+
+#include "ledlayout.h"
+#include "arena.h"
+
+using namespace GizmoLED;
+
+// Q15 to Q14
+inline int16_t LayoutSin(uint8_t angle)
+{
+	return Sin16(angle << 8) >> 1;
+}
+
+inline int16_t LayoutCos(uint8_t angle)
+{
+	return Cos16(angle << 8) >> 1;
+}
+
+// Leaves an empty layout if the arena runs out, effects then see zero LEDs
+bool AllocateLayout(Layout &layout, LayoutType type, uint16_t numLeds)
+{
+	const size_t mark = ArenaMark();
+	layout.type = type;
+	layout.numLeds = numLeds;
+	layout.x = ArenaAllocArray<int16_t>(numLeds);
+	layout.y = ArenaAllocArray<int16_t>(numLeds);
+	layout.polarAngle = ArenaAllocArray<uint8_t>(numLeds);
+	layout.polarRadius = ArenaAllocArray<uint8_t>(numLeds);
+	layout.projection = ArenaAllocArray<uint8_t>(numLeds);
+	layout.projectionAngle = -1;
+
+	if (layout.x == nullptr || layout.y == nullptr || layout.polarAngle == nullptr ||
+		layout.polarRadius == nullptr || layout.projection == nullptr)
+	{
+		ArenaRelease(mark);
+		layout.numLeds = 0;
+		return false;
+	}
+	return true;
+}
+
+// Allocates the layout followed by float coordinates to bake it from, released through scratchMark
+float *AllocateLayoutScratch(Layout &layout, LayoutType type, uint16_t numLeds, size_t &scratchMark)
+{
+	const size_t mark = ArenaMark();
+	if (!AllocateLayout(layout, type, numLeds))
+		return nullptr;
+
+	scratchMark = ArenaMark();
+	float *xy = ArenaAllocArray<float>(numLeds * 2);
+	if (xy == nullptr)
+	{
+		ArenaRelease(mark);
+		layout.numLeds = 0;
+	}
+	return xy;
+}
+
+// Normalizes float coordinates around the bounding box center and bakes the fixed point data
+void BakeLayout(Layout &layout, const float *xy)
+{
+	if (layout.numLeds == 0)
+		return;
+
+	float minX = xy[0], maxX = xy[0], minY = xy[1], maxY = xy[1];
+	for (int i = 1; i < layout.numLeds; ++i)
+	{
+		minX = MIN(minX, xy[i * 2]);
+		maxX = MAX(maxX, xy[i * 2]);
+		minY = MIN(minY, xy[i * 2 + 1]);
+		maxY = MAX(maxY, xy[i * 2 + 1]);
+	}
+
+	const float centerX = (minX + maxX) * 0.5f;
+	const float centerY = (minY + maxY) * 0.5f;
+	float maxRadius = 0.0f;
+	for (int i = 0; i < layout.numLeds; ++i)
+	{
+		const float dx = xy[i * 2] - centerX;
+		const float dy = xy[i * 2 + 1] - centerY;
+		maxRadius = MAX(maxRadius, sqrt(dx * dx + dy * dy));
+	}
+
+	const float scale = maxRadius > 0.0f ? 1.0f / maxRadius : 0.0f;
+	for (int i = 0; i < layout.numLeds; ++i)
+	{
+		const float dx = (xy[i * 2] - centerX) * scale;
+		const float dy = (xy[i * 2 + 1] - centerY) * scale;
+		layout.x[i] = int16_t(round(dx * LAYOUT_ONE));
+		layout.y[i] = int16_t(round(dy * LAYOUT_ONE));
+
+		float angle = atan2(dy, dx) * 256.0f / (2.0f * PI);
+		layout.polarAngle[i] = uint8_t(int(round(angle)) & 0xFF);
+		layout.polarRadius[i] = uint8_t(MIN(255, int(round(sqrt(dx * dx + dy * dy) * 255.0f))));
+	}
+}
+
+namespace GizmoLED
+{
+	void LayoutStrip(Layout &layout, uint16_t numLeds)
+	{
+		size_t mark;
+		float *xy = AllocateLayoutScratch(layout, LAYOUT_STRIP, numLeds, mark);
+		if (xy == nullptr)
+			return;
+
+		for (int i = 0; i < numLeds; ++i)
+		{
+			xy[i * 2] = i;
+			xy[i * 2 + 1] = 0.0f;
+		}
+		BakeLayout(layout, xy);
+		ArenaRelease(mark);
+	}
+
+	void LayoutRing(Layout &layout, uint16_t numLeds, uint8_t startAngle)
+	{
+		size_t mark;
+		float *xy = AllocateLayoutScratch(layout, LAYOUT_RING, numLeds, mark);
+		if (xy == nullptr)
+			return;
+
+		for (int i = 0; i < numLeds; ++i)
+		{
+			const float angle = (startAngle / 256.0f + float(i) / numLeds) * 2.0f * PI;
+			xy[i * 2] = cos(angle);
+			xy[i * 2 + 1] = sin(angle);
+		}
+		BakeLayout(layout, xy);
+		ArenaRelease(mark);
+	}
+
+	void LayoutMatrix(Layout &layout, uint8_t width, uint8_t height, bool serpentine)
+	{
+		const uint16_t numLeds = width * height;
+		size_t mark;
+		float *xy = AllocateLayoutScratch(layout, LAYOUT_MATRIX, numLeds, mark);
+		if (xy == nullptr)
+			return;
+
+		for (int row = 0; row < height; ++row)
+		{
+			for (int column = 0; column < width; ++column)
+			{
+				const bool reverse = serpentine && (row & 1);
+				const int i = row * width + (reverse ? width - 1 - column : column);
+				xy[i * 2] = column;
+				xy[i * 2 + 1] = row;
+			}
+		}
+		BakeLayout(layout, xy);
+		ArenaRelease(mark);
+	}
+
+	void LayoutPoints(Layout &layout, const float *xy, uint16_t numLeds)
+	{
+		if (AllocateLayout(layout, LAYOUT_POINTS, numLeds))
+		{
+			BakeLayout(layout, xy);
+		}
+	}
+
+	const uint8_t *GetLayoutProjection(Layout &layout, uint8_t angle)
+	{
+		if (layout.projectionAngle == angle)
+			return layout.projection;
+
+		const int32_t c = LayoutCos(angle);
+		const int32_t s = LayoutSin(angle);
+		for (int i = 0; i < layout.numLeds; ++i)
+		{
+			// Q14 * Q14 >> 14 is in [-LAYOUT_ONE, LAYOUT_ONE]
+			int32_t p = (layout.x[i] * c + layout.y[i] * s) >> 14;
+			p = MAX(-LAYOUT_ONE, MIN(LAYOUT_ONE, p));
+			layout.projection[i] = uint8_t(((p + LAYOUT_ONE) * 255 + LAYOUT_ONE) >> 15);
+		}
+
+		layout.projectionAngle = angle;
+		return layout.projection;
+	}
+
+	uint8_t GetLayoutAngle(const uint8_t *slider)
+	{
+		if (slider == nullptr)
+			return 0;
+
+		const int range = slider[2] - slider[1] + 1;
+		if (range <= 0)
+			return 0;
+
+		return uint8_t(((slider[0] - slider[1]) * 256) / range);
+	}
+}
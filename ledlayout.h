@@ -0,0 +1,48 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <gizmoled.h>
+
+#define LAYOUT_ONE 16384 // Coordinates are Q14, normalized to a radius of one
+
+namespace GizmoLED
+{
+	enum LayoutType
+	{
+		LAYOUT_STRIP = 0,
+		LAYOUT_RING,
+		LAYOUT_MATRIX,
+		LAYOUT_POINTS,
+	};
+
+	// LED positions baked at setup so effects can look up geometry
+	// instead of doing trig per LED and frame.
+	struct Layout
+	{
+		LayoutType type;
+		uint16_t numLeds; // 0 if the arena ran out
+
+		int16_t *x;
+		int16_t *y;
+		uint8_t *polarAngle; // Angle around the center, 256 steps per turn
+		uint8_t *polarRadius; // Distance from the center, 255 at the outermost LED
+
+		// Position of each LED along the direction of projectionAngle, 0-255
+		uint8_t *projection;
+		int16_t projectionAngle;
+	};
+
+	extern void LayoutStrip(Layout &layout, uint16_t numLeds);
+	extern void LayoutRing(Layout &layout, uint16_t numLeds, uint8_t startAngle = 0);
+	extern void LayoutMatrix(Layout &layout, uint8_t width, uint8_t height, bool serpentine);
+
+	// xy holds numLeds coordinate pairs in any unit
+	extern void LayoutPoints(Layout &layout, const float *xy, uint16_t numLeds);
+
+	// Projected positions for an angle (256 steps per turn), only rebuilt when the angle changes
+	extern const uint8_t *GetLayoutProjection(Layout &layout, uint8_t angle);
+
+	// Maps a VARNAME_ANGLE slider to 256 steps per turn
+	extern uint8_t GetLayoutAngle(const uint8_t *slider);
+}
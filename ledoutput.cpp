@@ -0,0 +1,62 @@
+#include "ledoutput.h"
+
+using namespace GizmoLED;
+
+static_assert(GammaTable::values[0] == 0, "gamma table must start at black");
+static_assert(GammaTable::values[255] == 65535, "gamma table must end at full scale");
+
+uint16_t outputScale = 256; // 8.8 fixed point
+bool outputDithering = false;
+bool outputUsed = false;
+uint8_t outputFrame = 0;
+
+namespace GizmoLED
+{
+	void SetOutputBrightness(uint8_t brightness)
+	{
+		outputScale = brightness == 0 ? 0 : brightness + 1;
+	}
+
+	uint8_t GetOutputBrightness()
+	{
+		return outputScale == 0 ? 0 : outputScale - 1;
+	}
+
+	void SetOutputDithering(bool enabled)
+	{
+		outputDithering = enabled;
+	}
+
+	bool IsOutputDitheringActive()
+	{
+		return outputUsed && outputDithering;
+	}
+
+	void AdvanceOutputFrame()
+	{
+		++outputFrame;
+	}
+
+	void ApplyOutput(const uint8_t *src, uint8_t *dst, int numBytes)
+	{
+		const uint16_t *gamma = GammaTable::values;
+		const uint32_t scale = outputScale;
+		outputUsed = true;
+
+		// Bit reversed frame counter spreads the threshold evenly over 8 frames,
+		// the fraction below one LED step then averages out over time
+		uint32_t dither = 0;
+		if (outputDithering)
+		{
+			const uint8_t f = outputFrame & 0x7;
+			dither = ((f & 1) << 7) | ((f & 2) << 5) | ((f & 4) << 3);
+		}
+
+		for (int i = 0; i < numBytes; ++i)
+		{
+			uint32_t value = ((gamma[src[i]] * scale) >> 8) + dither;
+			value >>= 8;
+			dst[i] = value > 255 ? 255 : value;
+		}
+	}
+}
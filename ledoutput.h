@@ -0,0 +1,97 @@
+#pragma once
+
+#include <Arduino.h>
+
+#ifndef OUTPUT_GAMMA
+#define OUTPUT_GAMMA 2.2
+#endif
+
+namespace GizmoLED
+{
+	// Compile time math used to generate the gamma table
+	namespace GammaMath
+	{
+		constexpr double Ln2 = 0.69314718055994530942;
+
+		// atanh series, ln(m) = 2 * atanh((m - 1) / (m + 1))
+		constexpr double LnSeries(double z2, double term, int n, int terms)
+		{
+			return n > terms ? 0.0 : term / n + LnSeries(z2, term * z2, n + 2, terms);
+		}
+
+		// Reduces x to [0.5, 1) and accumulates the power of two
+		constexpr double Ln(double x, int exponent = 0)
+		{
+			return x < 0.5 ? Ln(x * 2.0, exponent - 1) :
+				2.0 * LnSeries(((x - 1.0) / (x + 1.0)) * ((x - 1.0) / (x + 1.0)), (x - 1.0) / (x + 1.0), 1, 41) + exponent * Ln2;
+		}
+
+		constexpr double ExpSeries(double x, double term, int n)
+		{
+			return n > 40 ? term : term + ExpSeries(x, term * x / n, n + 1);
+		}
+
+		// The series only converges well without alternating signs, dark levels need e^-12
+		constexpr double Exp(double x)
+		{
+			return x < 0.0 ? 1.0 / ExpSeries(-x, 1.0, 1) : ExpSeries(x, 1.0, 1);
+		}
+
+		constexpr double Pow(double x, double y)
+		{
+			return x <= 0.0 ? 0.0 : Exp(y * Ln(x));
+		}
+
+		// 16 bit output keeps precision for dithering
+		constexpr uint16_t Gamma16(int i)
+		{
+			return uint16_t(Pow(i / 255.0, OUTPUT_GAMMA) * 65535.0 + 0.5);
+		}
+
+		template<int... I>
+		struct Sequence {};
+
+		template<int N, int... I>
+		struct MakeSequence : MakeSequence<N - 1, N - 1, I...> {};
+
+		template<int... I>
+		struct MakeSequence<0, I...>
+		{
+			typedef Sequence<I...> Type;
+		};
+
+		template<typename S>
+		struct Table;
+
+		template<int... I>
+		struct Table<Sequence<I...>>
+		{
+			static constexpr uint16_t values[sizeof...(I)] = { Gamma16(I)... };
+		};
+
+		template<int... I>
+		constexpr uint16_t Table<Sequence<I...>>::values[sizeof...(I)];
+	}
+
+	typedef GammaMath::Table<GammaMath::MakeSequence<256>::Type> GammaTable;
+
+	// Final stage before the LED driver: gamma, global brightness and
+	// temporal dithering in a single pass over the frame.
+	extern void SetOutputBrightness(uint8_t brightness);
+	extern uint8_t GetOutputBrightness();
+	// Dithering is off by default. Turning it on costs the idle sleep: the output
+	// changes every frame, so GizmoLEDLoop keeps running at the effect frame rate
+	// on static effects and only rendering is skipped.
+	extern void SetOutputDithering(bool enabled);
+
+	// True once ApplyOutput runs with dithering on, the sketch must then refresh
+	// the output every frame.
+	extern bool IsOutputDitheringActive();
+
+	// Steps the dither pattern, once per frame. GizmoLEDLoop calls it, so every
+	// ApplyOutput of a frame (one per strip) uses the same threshold.
+	extern void AdvanceOutputFrame();
+
+	// src and dst may be the same buffer, numBytes is pixels * channels
+	extern void ApplyOutput(const uint8_t *src, uint8_t *dst, int numBytes);
+}
@@ -0,0 +1,275 @@
+#include <ArduinoBLE.h>
+
+#include <utility/ATT.h>
+#include <utility/HCI.h>
+
+#include "linkpolicy.h"
+#include "clocksync.h"
+
+#define L2CAP_SIGNALING_CID 0x0005
+#define L2CAP_CONNECTION_PARAMETER_UPDATE_REQUEST 0x12
+#define NO_CONNECTION_HANDLE 0xFFFF
+
+using namespace GizmoLED;
+
+namespace GizmoLED
+{
+	const LinkPolicy linkPolicies[NUM_LINKPOLICIES] =
+	{
+		// Idle, static output and nobody touching settings
+		{ 80, 160, 4, 600, 1600, 0.2f },
+		// Interactive, settings are being changed
+		{ 12, 24, 0, 400, 320, 0.1f },
+		// Realtime, visualizer audio and frame streaming
+		{ 6, 6, 0, 400, 160, 0.0f },
+	};
+}
+
+LinkPolicyName currentLinkPolicy = LINKPOLICY_INTERACTIVE;
+LinkPolicyStats linkPolicyStats[NUM_LINKPOLICIES] = {};
+
+unsigned long lastLinkEvaluation = 0;
+unsigned long lastLinkWrite = 0;
+unsigned long lastLinkPoll = 0;
+uint16_t linkWindowWrites = 0;
+float linkWriteRate = 0.0f;
+
+uint16_t linkConnectionHandle = NO_CONNECTION_HANDLE;
+uint8_t linkRequestIdentifier = 0;
+LinkPolicy linkParameters = {};
+
+const char *linkPolicyNames[NUM_LINKPOLICIES] = { "idle", "interactive", "realtime" };
+
+// ArduinoBLE prints addresses most significant byte first
+bool ParseAddress(const String &text, uint8_t address[6])
+{
+	const char *read = text.c_str();
+	for (int i = 5; i >= 0; --i)
+	{
+		char *end;
+		const long value = strtol(read, &end, 16);
+		if (end == read || value < 0 || value > 255)
+			return false;
+
+		address[i] = value;
+		read = *end == ':' ? end + 1 : end;
+	}
+	return true;
+}
+
+// L2CAP connection parameter update request, the only way a peripheral can
+// renegotiate an existing connection, also the only one that carries latency
+void RequestConnectionParameters(const LinkPolicy &policy)
+{
+	struct __attribute__((packed))
+	{
+		uint8_t code;
+		uint8_t identifier;
+		uint16_t length;
+		uint16_t minInterval;
+		uint16_t maxInterval;
+		uint16_t latency;
+		uint16_t supervisionTimeout;
+	} request = {
+		L2CAP_CONNECTION_PARAMETER_UPDATE_REQUEST, 0, 8,
+		policy.minInterval, policy.maxInterval, policy.latency, policy.supervisionTimeout };
+
+	// Identifier 0 is invalid
+	if (++linkRequestIdentifier == 0)
+	{
+		linkRequestIdentifier = 1;
+	}
+	request.identifier = linkRequestIdentifier;
+
+	HCI.sendAclPkt(linkConnectionHandle, L2CAP_SIGNALING_CID, sizeof request, &request);
+	linkParameters = policy;
+}
+
+// A sync master keeps advertising its beacons at the sync interval
+uint16_t GetAdvertisingInterval(const LinkPolicy &policy)
+{
+	return GetSyncRole() == SYNCROLE_MASTER ? SYNC_ADVERTISING_INTERVAL : policy.advertisingInterval;
+}
+
+void ApplyLinkPolicy(const LinkPolicy &policy)
+{
+	// Preferred parameters are what ArduinoBLE asks for on the next connection
+	BLE.setConnectionInterval(policy.minInterval, policy.maxInterval);
+	BLE.setSupervisionTimeout(policy.supervisionTimeout);
+
+	if (BLE.connected() && linkConnectionHandle != NO_CONNECTION_HANDLE)
+	{
+		RequestConnectionParameters(policy);
+	}
+
+	if (!BLE.connected())
+	{
+		BLE.stopAdvertise();
+		BLE.setAdvertisingInterval(GetAdvertisingInterval(policy));
+		BLE.advertise();
+	}
+}
+
+namespace GizmoLED
+{
+	// Estimates how often the radio woke up during the elapsed time
+	uint32_t EstimateRadioEvents(const LinkPolicy &parameters, bool connected, unsigned long elapsedMillis)
+	{
+		if (connected)
+		{
+			const uint32_t eventMicros = parameters.minInterval * 1250UL * (parameters.latency + 1);
+			return elapsedMillis * 1000UL / eventMicros;
+		}
+
+		// Three advertising channels per event
+		return elapsedMillis * 1000UL * 3 / (parameters.advertisingInterval * 625UL);
+	}
+
+	LinkPolicyName ChooseLinkPolicy(EffectType type, float writeRate, unsigned long idleMillis)
+	{
+		if (type == EFFECTTYPE_VISUALIZER || type == EFFECTTYPE_STREAM ||
+			writeRate >= LINK_REALTIME_WRITE_RATE)
+		{
+			return LINKPOLICY_REALTIME;
+		}
+
+		if (idleMillis < LINK_IDLE_TIME)
+		{
+			return LINKPOLICY_INTERACTIVE;
+		}
+
+		return LINKPOLICY_IDLE;
+	}
+
+	void LinkPolicyNotifyWrite()
+	{
+		++linkWindowWrites;
+		++linkPolicyStats[currentLinkPolicy].writes;
+		lastLinkWrite = millis();
+	}
+
+	void LinkPolicyNotifyPoll()
+	{
+		const unsigned long now = micros();
+		LinkPolicyStats &stats = linkPolicyStats[currentLinkPolicy];
+		stats.pollGapMicros = (stats.pollGapMicros * 15 + (now - lastLinkPoll)) / 16;
+		lastLinkPoll = now;
+	}
+
+	void LinkPolicyConnected(BLEDevice device)
+	{
+		// ArduinoBLE requests the preferred interval itself right after connecting,
+		// a second request would overlap it so latency waits for the next policy change
+		linkParameters = linkPolicies[currentLinkPolicy];
+		linkParameters.latency = 0;
+
+		// Public or random address, the event doesn't say which
+		linkConnectionHandle = NO_CONNECTION_HANDLE;
+		uint8_t address[6];
+		if (ParseAddress(device.address(), address))
+		{
+			for (uint8_t addressType = 0; addressType <= 1; ++addressType)
+			{
+				linkConnectionHandle = ATT.connectionHandle(addressType, address);
+				if (linkConnectionHandle != NO_CONNECTION_HANDLE)
+					break;
+			}
+		}
+	}
+
+	void LinkPolicyDisconnected()
+	{
+		linkConnectionHandle = NO_CONNECTION_HANDLE;
+	}
+
+	void BeginLinkPolicy(EffectType type)
+	{
+		lastLinkEvaluation = millis();
+		lastLinkWrite = lastLinkEvaluation;
+		lastLinkPoll = micros();
+
+		currentLinkPolicy = ChooseLinkPolicy(type, 0.0f, 0);
+		++linkPolicyStats[currentLinkPolicy].entered;
+	}
+
+	bool UpdateLinkPolicy(EffectType type, bool immediate)
+	{
+		const unsigned long now = millis();
+		const unsigned long elapsed = now - lastLinkEvaluation;
+		if (elapsed >= LINK_EVALUATE_INTERVAL)
+		{
+			lastLinkEvaluation = now;
+
+			const bool connected = BLE.connected();
+			LinkPolicyStats &stats = linkPolicyStats[currentLinkPolicy];
+			stats.activeMillis += elapsed;
+			LinkPolicy parameters = connected ? linkParameters : linkPolicies[currentLinkPolicy];
+			parameters.advertisingInterval = GetAdvertisingInterval(parameters);
+			stats.radioEvents += EstimateRadioEvents(parameters, connected, elapsed);
+			if (connected)
+			{
+				stats.connectedMillis += elapsed;
+			}
+
+			const float windowRate = linkWindowWrites * 1000.0f / elapsed;
+			linkWriteRate = linkWriteRate * 0.5f + windowRate * 0.5f;
+			linkWindowWrites = 0;
+		}
+		else if (!immediate)
+		{
+			return false;
+		}
+
+		// An immediate evaluation within the window only reacts to the new effect type,
+		// a few milliseconds of writes would read as a huge rate
+		const LinkPolicyName policy = ChooseLinkPolicy(type, linkWriteRate, now - lastLinkWrite);
+		if (policy == currentLinkPolicy)
+			return false;
+
+		currentLinkPolicy = policy;
+		++linkPolicyStats[policy].entered;
+		ApplyLinkPolicy(linkPolicies[policy]);
+		return true;
+	}
+
+	LinkPolicyName GetLinkPolicyName()
+	{
+		return currentLinkPolicy;
+	}
+
+	const LinkPolicy &GetLinkPolicy()
+	{
+		return linkPolicies[currentLinkPolicy];
+	}
+
+	const LinkPolicy &GetLinkParameters()
+	{
+		return linkParameters;
+	}
+
+	const LinkPolicyStats &GetLinkPolicyStats(LinkPolicyName name)
+	{
+		return linkPolicyStats[name];
+	}
+
+	void PrintLinkPolicyStats()
+	{
+		Serial.println("Link policy: " + String(linkPolicyNames[currentLinkPolicy]) +
+			", writes/s: " + String(linkWriteRate) +
+			", requested interval: " + String(linkParameters.minInterval * 1.25f) + "-" +
+			String(linkParameters.maxInterval * 1.25f) + "ms" +
+			", latency: " + String(linkParameters.latency) +
+			(linkConnectionHandle == NO_CONNECTION_HANDLE ? ", no handle" : ""));
+		for (int i = 0; i < NUM_LINKPOLICIES; ++i)
+		{
+			const LinkPolicyStats &stats = linkPolicyStats[i];
+			Serial.println(String(linkPolicyNames[i]) +
+				": active " + String(stats.activeMillis) + "ms" +
+				", connected " + String(stats.connectedMillis) + "ms" +
+				", radio events ~" + String(stats.radioEvents) +
+				", writes " + String(stats.writes) +
+				", poll gap " + String(stats.pollGapMicros) + "us" +
+				", entered " + String(stats.entered));
+		}
+	}
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <gizmoled.h>
+
+#define LINK_EVALUATE_INTERVAL 1000 // ms
+#define LINK_IDLE_TIME 30000 // ms without writes before dropping to the idle policy
+#define LINK_REALTIME_WRITE_RATE 10.0f // Writes per second that need the realtime policy
+
+namespace GizmoLED
+{
+	enum LinkPolicyName
+	{
+		LINKPOLICY_IDLE = 0,
+		LINKPOLICY_INTERACTIVE,
+		LINKPOLICY_REALTIME,
+		NUM_LINKPOLICIES,
+	};
+
+	struct LinkPolicy
+	{
+		uint16_t minInterval; // 1.25ms units
+		uint16_t maxInterval;
+		uint16_t latency; // Connection events the peripheral may skip
+		uint16_t supervisionTimeout; // 10ms units
+		uint16_t advertisingInterval; // 0.625ms units
+		float bleUpdateDelay; // Seconds between BLE polls
+	};
+
+	struct LinkPolicyStats
+	{
+		uint32_t activeMillis;
+		uint32_t connectedMillis;
+		uint32_t radioEvents; // Estimated from the intervals
+		uint32_t writes;
+		uint32_t pollGapMicros; // Smoothed time between polls, writes wait half of it on average
+		uint32_t entered;
+	};
+
+	extern const LinkPolicy linkPolicies[NUM_LINKPOLICIES];
+
+	// Pure decision so traffic traces can be replayed against it
+	extern LinkPolicyName ChooseLinkPolicy(EffectType type, float writeRate, unsigned long idleMillis);
+
+	extern void LinkPolicyNotifyWrite();
+	extern void LinkPolicyNotifyPoll();
+
+	// Looks up the connection handle so policy changes renegotiate the live connection
+	extern void LinkPolicyConnected(BLEDevice device);
+	extern void LinkPolicyDisconnected();
+
+	// Selects the initial policy before BLE is started, the caller applies it
+	extern void BeginLinkPolicy(EffectType type);
+
+	// Re-evaluates the policy and applies it when it changed, returns true in that case.
+	// Evaluation runs every LINK_EVALUATE_INTERVAL. Immediate also re-chooses between
+	// evaluations for a new effect type, with the write rate of the last full window.
+	extern bool UpdateLinkPolicy(EffectType type, bool immediate = false);
+
+	extern LinkPolicyName GetLinkPolicyName();
+	extern const LinkPolicy &GetLinkPolicy();
+
+	// Connection parameters last requested on the current connection. ArduinoBLE asks for
+	// the preferred interval without latency on connect, latency only applies once an
+	// update request carrying it was sent.
+	extern const LinkPolicy &GetLinkParameters();
+
+	// Upper bound, the central picks an interval between min and max
+	extern uint32_t EstimateRadioEvents(const LinkPolicy &parameters, bool connected, unsigned long elapsedMillis);
+
+	extern const LinkPolicyStats &GetLinkPolicyStats(LinkPolicyName name);
+	extern void PrintLinkPolicyStats();
+}
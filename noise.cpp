@@ -0,0 +1,197 @@
+#include "noise.h"
+
+using namespace GizmoLED;
+
+// Simplex skew factors in Q30, precise enough to unskew exactly far from the origin
+#define SIMPLEX_F2 393016785ULL // (sqrt(3) - 1) / 2
+#define SIMPLEX_G2 226908346ULL // (3 - sqrt(3)) / 6
+#define SIMPLEX_G2_Q8 54
+
+// Output scales, chosen so the sums cover the full output range
+#define SIMPLEX1D_SCALE 50
+#define SIMPLEX2D_SCALE 22
+
+inline uint32_t NoiseHash(uint32_t x, uint32_t seed)
+{
+	x ^= seed;
+	x ^= x >> 16;
+	x *= 0x7FEB352D;
+	x ^= x >> 15;
+	x *= 0x846CA68B;
+	x ^= x >> 16;
+	return x;
+}
+
+inline uint32_t NoiseHash(uint32_t x, uint32_t y, uint32_t seed)
+{
+	return NoiseHash(x ^ NoiseHash(y, seed), seed);
+}
+
+// Q8 smoothstep, 3f^2 - 2f^3
+inline uint32_t NoiseFade(uint32_t f)
+{
+	return (f * f * (768 - 2 * f)) >> 16;
+}
+
+inline uint8_t NoiseLerp(uint8_t a, uint8_t b, uint32_t f)
+{
+	return (a * (256 - f) + b * f) >> 8;
+}
+
+inline uint8_t NoiseClamp(int32_t value)
+{
+	value += 128;
+	return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+// t^4 falloff of a simplex corner, t is Q16 and returns Q12
+inline int32_t SimplexFalloff(int32_t t)
+{
+	if (t <= 0)
+		return 0;
+
+	t >>= 4;
+	t = (t * t) >> 12;
+	return (t * t) >> 12;
+}
+
+// One of 8 gradient directions with lengths 1-2, x and y are Q8
+inline int32_t SimplexGrad(uint32_t hash, int32_t x, int32_t y)
+{
+	const int32_t u = (hash & 4) ? y : x;
+	const int32_t v = (hash & 4) ? x : y;
+	return ((hash & 1) ? -u : u) + ((hash & 2) ? -2 * v : 2 * v);
+}
+
+namespace GizmoLED
+{
+	void RandomFill(Random &random, uint8_t *dst, int count)
+	{
+		uint32_t x = random.state;
+		int i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			x ^= x << 13;
+			x ^= x >> 17;
+			x ^= x << 5;
+			dst[i] = x;
+			dst[i + 1] = x >> 8;
+			dst[i + 2] = x >> 16;
+			dst[i + 3] = x >> 24;
+		}
+
+		if (i < count)
+		{
+			x ^= x << 13;
+			x ^= x >> 17;
+			x ^= x << 5;
+
+			// Shift a copy, the state has to keep all 32 bits
+			uint32_t tail = x;
+			for (; i < count; ++i)
+			{
+				dst[i] = tail;
+				tail >>= 8;
+			}
+		}
+
+		random.state = x;
+	}
+
+	uint8_t ValueNoise1D(uint32_t x, uint32_t seed)
+	{
+		const uint32_t i = x >> 8;
+		const uint32_t f = NoiseFade(x & 0xFF);
+		return NoiseLerp(NoiseHash(i, seed), NoiseHash(i + 1, seed), f);
+	}
+
+	uint8_t ValueNoise2D(uint32_t x, uint32_t y, uint32_t seed)
+	{
+		const uint32_t i = x >> 8;
+		const uint32_t j = y >> 8;
+		const uint32_t fx = NoiseFade(x & 0xFF);
+		const uint32_t fy = NoiseFade(y & 0xFF);
+		const uint8_t a = NoiseLerp(NoiseHash(i, j, seed), NoiseHash(i + 1, j, seed), fx);
+		const uint8_t b = NoiseLerp(NoiseHash(i, j + 1, seed), NoiseHash(i + 1, j + 1, seed), fx);
+		return NoiseLerp(a, b, fy);
+	}
+
+	uint8_t SimplexNoise1D(uint32_t x, uint32_t seed)
+	{
+		const uint32_t i = x >> 8;
+		const int32_t x0 = x & 0xFF;
+		const int32_t x1 = x0 - 256;
+
+		// Gradients -8..8 excluding 0
+		const uint32_t h0 = NoiseHash(i, seed);
+		const uint32_t h1 = NoiseHash(i + 1, seed);
+		const int32_t g0 = ((h0 & 7) + 1) * ((h0 & 8) ? -x0 : x0);
+		const int32_t g1 = ((h1 & 7) + 1) * ((h1 & 8) ? -x1 : x1);
+
+		const int32_t n0 = SimplexFalloff(65536 - x0 * x0) * g0;
+		const int32_t n1 = SimplexFalloff(65536 - x1 * x1) * g1;
+		return NoiseClamp(((n0 + n1) >> 12) * SIMPLEX1D_SCALE >> 8);
+	}
+
+	uint8_t SimplexNoise2D(uint32_t x, uint32_t y, uint32_t seed)
+	{
+		// Skew into simplex cell space
+		const uint64_t s = ((uint64_t(x) + y) * SIMPLEX_F2) >> 30;
+		const uint64_t i = (x + s) >> 8;
+		const uint64_t j = (y + s) >> 8;
+
+		// Unskew the cell origin back, only the small local offsets are kept
+		const int64_t t = ((i + j) * SIMPLEX_G2) >> 22;
+		const int32_t x0 = int32_t(int64_t(x) - int64_t(i << 8) + t);
+		const int32_t y0 = int32_t(int64_t(y) - int64_t(j << 8) + t);
+
+		const int32_t i1 = x0 > y0 ? 1 : 0;
+		const int32_t j1 = 1 - i1;
+
+		const int32_t x1 = x0 - i1 * 256 + SIMPLEX_G2_Q8;
+		const int32_t y1 = y0 - j1 * 256 + SIMPLEX_G2_Q8;
+		const int32_t x2 = x0 - 256 + 2 * SIMPLEX_G2_Q8;
+		const int32_t y2 = y0 - 256 + 2 * SIMPLEX_G2_Q8;
+
+		const int32_t n0 = SimplexFalloff(32768 - x0 * x0 - y0 * y0) *
+			SimplexGrad(NoiseHash(i, j, seed), x0, y0);
+		const int32_t n1 = SimplexFalloff(32768 - x1 * x1 - y1 * y1) *
+			SimplexGrad(NoiseHash(i + i1, j + j1, seed), x1, y1);
+		const int32_t n2 = SimplexFalloff(32768 - x2 * x2 - y2 * y2) *
+			SimplexGrad(NoiseHash(i + 1, j + 1, seed), x2, y2);
+
+		return NoiseClamp(((n0 + n1 + n2) >> 4) * SIMPLEX2D_SCALE >> 8);
+	}
+
+	void ValueNoiseFill1D(uint8_t *dst, int count, uint32_t x, uint32_t dx, uint32_t seed)
+	{
+		for (int i = 0; i < count; ++i, x += dx)
+		{
+			dst[i] = ValueNoise1D(x, seed);
+		}
+	}
+
+	void ValueNoiseFill2D(uint8_t *dst, int count, uint32_t x, uint32_t y, uint32_t dx, uint32_t dy, uint32_t seed)
+	{
+		for (int i = 0; i < count; ++i, x += dx, y += dy)
+		{
+			dst[i] = ValueNoise2D(x, y, seed);
+		}
+	}
+
+	void SimplexNoiseFill1D(uint8_t *dst, int count, uint32_t x, uint32_t dx, uint32_t seed)
+	{
+		for (int i = 0; i < count; ++i, x += dx)
+		{
+			dst[i] = SimplexNoise1D(x, seed);
+		}
+	}
+
+	void SimplexNoiseFill2D(uint8_t *dst, int count, uint32_t x, uint32_t y, uint32_t dx, uint32_t dy, uint32_t seed)
+	{
+		for (int i = 0; i < count; ++i, x += dx, y += dy)
+		{
+			dst[i] = SimplexNoise2D(x, y, seed);
+		}
+	}
+}
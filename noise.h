@@ -0,0 +1,61 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace GizmoLED
+{
+	// Small state xorshift32 generator, much cheaper than Arduino random()
+	struct Random
+	{
+		uint32_t state;
+	};
+
+	inline void RandomSeed(Random &random, uint32_t seed)
+	{
+		// Zero is the only invalid xorshift state
+		random.state = seed != 0 ? seed : 0x9E3779B9;
+	}
+
+	inline uint32_t Random32(Random &random)
+	{
+		uint32_t x = random.state;
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		random.state = x;
+		return x;
+	}
+
+	inline uint16_t Random16(Random &random)
+	{
+		return Random32(random) >> 16;
+	}
+
+	inline uint8_t Random8(Random &random)
+	{
+		return Random32(random) >> 24;
+	}
+
+	// Uniform in [0, limit)
+	inline uint8_t Random8(Random &random, uint8_t limit)
+	{
+		return (uint16_t(Random8(random)) * limit) >> 8;
+	}
+
+	// Fills a whole buffer, e.g. one random byte per LED. The bytes are the same as those
+	// of consecutive Random32() calls in little endian order.
+	extern void RandomFill(Random &random, uint8_t *dst, int count);
+
+	// Noise inputs are 8.8 fixed point lattice coordinates, outputs are 0-255 centered at 128.
+	// All functions are deterministic for the same seed.
+	extern uint8_t ValueNoise1D(uint32_t x, uint32_t seed = 0);
+	extern uint8_t ValueNoise2D(uint32_t x, uint32_t y, uint32_t seed = 0);
+	extern uint8_t SimplexNoise1D(uint32_t x, uint32_t seed = 0);
+	extern uint8_t SimplexNoise2D(uint32_t x, uint32_t y, uint32_t seed = 0);
+
+	// Batch versions sample count points starting at x/y and stepping by dx/dy
+	extern void ValueNoiseFill1D(uint8_t *dst, int count, uint32_t x, uint32_t dx, uint32_t seed = 0);
+	extern void ValueNoiseFill2D(uint8_t *dst, int count, uint32_t x, uint32_t y, uint32_t dx, uint32_t dy, uint32_t seed = 0);
+	extern void SimplexNoiseFill1D(uint8_t *dst, int count, uint32_t x, uint32_t dx, uint32_t seed = 0);
+	extern void SimplexNoiseFill2D(uint8_t *dst, int count, uint32_t x, uint32_t y, uint32_t dx, uint32_t dy, uint32_t seed = 0);
+}
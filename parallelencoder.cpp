@@ -0,0 +1,121 @@
+#include <ArduinoBLE.h>
+
+#include "parallelencoder.h"
+#include "gizmoled.h"
+
+// PARALLEL_NO_SIMD forces the portable path, the host tests build both
+#if defined(__SSE2__) && !defined(PARALLEL_NO_SIMD)
+#define PARALLEL_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace GizmoLED;
+
+// 8x8 bit matrix transpose, byte k of x holds row k
+inline uint64_t Transpose8x8(uint64_t x)
+{
+	uint64_t t;
+	t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+	x ^= t ^ (t << 7);
+	t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+	x ^= t ^ (t << 14);
+	t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+	x ^= t ^ (t << 28);
+	return x;
+}
+
+// Byte i of up to 8 strips, strip s in byte s
+inline uint64_t GatherStrips(const uint8_t *const *strips, uint8_t numStrips, int i)
+{
+	uint64_t x = 0;
+	for (int s = 0; s < numStrips; ++s)
+	{
+		if (strips[s] != nullptr)
+		{
+			x |= uint64_t(strips[s][i]) << (s * 8);
+		}
+	}
+	return x;
+}
+
+// Writes the 8 slices of one input byte position, MSB first, stride bytes apart
+inline void WriteSlices(uint64_t transposed, uint8_t *out, int stride)
+{
+	for (int b = 7; b >= 0; --b)
+	{
+		*out = uint8_t(transposed >> (b * 8));
+		out += stride;
+	}
+}
+
+#if defined(PARALLEL_SSE2)
+// Two byte positions per vector, the sign bit mask of each byte lane is one slice
+void ParallelEncodeSSE2(const uint8_t *const *strips, uint8_t numStrips, int numBytes, uint8_t *out)
+{
+	int i = 0;
+	for (; i + 2 <= numBytes; i += 2)
+	{
+		const uint64_t a = GatherStrips(strips, numStrips, i);
+		const uint64_t b = GatherStrips(strips, numStrips, i + 1);
+		__m128i v = _mm_set_epi64x(int64_t(b), int64_t(a));
+
+		uint8_t *outA = out + i * 8;
+		uint8_t *outB = outA + 8;
+		for (int bit = 0; bit < 8; ++bit)
+		{
+			const int mask = _mm_movemask_epi8(v);
+			outA[bit] = uint8_t(mask);
+			outB[bit] = uint8_t(mask >> 8);
+			v = _mm_add_epi8(v, v);
+		}
+	}
+
+	for (; i < numBytes; ++i)
+	{
+		WriteSlices(Transpose8x8(GatherStrips(strips, numStrips, i)), out + i * 8, 1);
+	}
+}
+#endif
+
+namespace GizmoLED
+{
+	void ParallelEncode(const uint8_t *const *strips, uint8_t numStrips, int numBytes, uint8_t *out)
+	{
+		numStrips = MIN(numStrips, PARALLEL_STRIPS_PER_LANE);
+
+#if defined(PARALLEL_SSE2)
+		ParallelEncodeSSE2(strips, numStrips, numBytes, out);
+#else
+		for (int i = 0; i < numBytes; ++i)
+		{
+			WriteSlices(Transpose8x8(GatherStrips(strips, numStrips, i)), out + i * 8, 1);
+		}
+#endif
+	}
+
+	void ParallelEncodeLanes(const uint8_t *const *strips, uint8_t numStrips, int numBytes, uint8_t *out)
+	{
+		const int numLanes = (numStrips + PARALLEL_STRIPS_PER_LANE - 1) / PARALLEL_STRIPS_PER_LANE;
+		for (int lane = 0; lane < numLanes; ++lane)
+		{
+			const uint8_t *const *laneStrips = strips + lane * PARALLEL_STRIPS_PER_LANE;
+			const uint8_t laneCount = MIN(numStrips - lane * PARALLEL_STRIPS_PER_LANE, PARALLEL_STRIPS_PER_LANE);
+			for (int i = 0; i < numBytes; ++i)
+			{
+				WriteSlices(Transpose8x8(GatherStrips(laneStrips, laneCount, i)),
+					out + i * 8 * numLanes + lane, numLanes);
+			}
+		}
+	}
+
+	void ParallelExpandWS2812(const uint8_t *slices, int numSlices, uint8_t *out)
+	{
+		for (int i = 0; i < numSlices; ++i)
+		{
+			out[0] = 0xFF;
+			out[1] = slices[i];
+			out[2] = 0x00;
+			out += PARALLEL_WS2812_SLOTS;
+		}
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <Arduino.h>
+
+#define PARALLEL_STRIPS_PER_LANE 8
+#define PARALLEL_WS2812_SLOTS 3 // Output slots per data bit
+
+// Hardware independent encoder for driving several LED strips from one parallel
+// I2S/RMT/SPI DMA stream. Each output byte is one bit time on a lane of 8 data
+// lines, bit s of the byte is the level of strip s.
+
+namespace GizmoLED
+{
+	// Bit slices of up to 8 strips, out receives 8 bytes per input byte (MSB first).
+	// Strips may be nullptr to output zeros.
+	extern void ParallelEncode(const uint8_t *const *strips, uint8_t numStrips, int numBytes, uint8_t *out);
+
+	// Like ParallelEncode for more than 8 strips, strip s goes to lane s / 8.
+	// Lanes are interleaved per bit slot, e.g. 16 bit wide I2S takes lane 0 and 1 bytes in turn.
+	extern void ParallelEncodeLanes(const uint8_t *const *strips, uint8_t numStrips, int numBytes, uint8_t *out);
+
+	// Expands bit slices to WS2812 timing with 3 slots per bit: high, data, low
+	extern void ParallelExpandWS2812(const uint8_t *slices, int numSlices, uint8_t *out);
+}